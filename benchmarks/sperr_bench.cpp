@@ -0,0 +1,456 @@
+//
+// Benchmarks of every stage of the SPERR pipeline, using Google Benchmark.
+//
+// Every stage runs on a synthetic volume of a configurable dimension, and on data sets from
+//    test_data/. Besides the standard flags of Google Benchmark, it accepts:
+//    --sperr_dims=X,Y,Z      dimension of the synthetic volume (default: 128,128,128)
+//    --sperr_data_dir=DIR    directory of the test data sets (default: test_data/ of the source)
+// Results are written to `sperr_bench.json` in JSON, unless `--benchmark_out` says otherwise,
+//    so that they can be compared across builds (e.g., with `compare.py` of Google Benchmark).
+//
+
+#include "CDF97.h"
+#include "Conditioner.h"
+#include "Outlier_Coder.h"
+#include "SPECK3D_FLT.h"
+#include "SPERR3D_OMP_C.h"
+#include "SPERR3D_OMP_D.h"
+
+#include "SPECK1D_INT_DEC.h"
+#include "SPECK1D_INT_ENC.h"
+#include "SPECK2D_INT_DEC.h"
+#include "SPECK2D_INT_ENC.h"
+#include "SPECK3D_INT_DEC.h"
+#include "SPECK3D_INT_ENC.h"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+
+#ifndef SPERR_TEST_DATA_DIR
+#define SPERR_TEST_DATA_DIR "../test_data"
+#endif
+
+namespace {
+
+struct Input {
+  std::string name;
+  sperr::dims_type dims = {0, 0, 0};
+  sperr::vecd_type vals;
+};
+
+// A smooth field with some noise, which compresses somewhat like real data.
+auto make_synthetic(sperr::dims_type dims) -> Input
+{
+  auto in = Input{"synthetic", dims, sperr::vecd_type(dims[0] * dims[1] * dims[2])};
+  std::mt19937 gen{17};
+  std::normal_distribution<double> noise{0.0, 0.01};
+  size_t idx = 0;
+  for (size_t z = 0; z < dims[2]; z++) {
+    for (size_t y = 0; y < dims[1]; y++) {
+      for (size_t x = 0; x < dims[0]; x++) {
+        in.vals[idx++] = std::sin(0.05 * x) * std::cos(0.07 * y) + std::sin(0.03 * (x + z)) +
+                         0.5 * std::cos(0.11 * z) + noise(gen);
+      }
+    }
+  }
+  return in;
+}
+
+auto read_input(const std::string& dir, std::string name, sperr::dims_type dims) -> Input
+{
+  auto in = Input{std::move(name), dims, {}};
+  const auto vals = sperr::read_whole_file<float>(dir + "/" + in.name);
+  if (vals.size() == dims[0] * dims[1] * dims[2])
+    in.vals.assign(vals.cbegin(), vals.cend());
+  else
+    std::cerr << "Skipping " << dir << "/" << in.name << ", which can't be read." << std::endl;
+  return in;
+}
+
+// The first XY plane of a 3D input.
+auto first_plane(const Input& in) -> Input
+{
+  const auto plane_size = in.dims[0] * in.dims[1];
+  auto plane = Input{in.name, {in.dims[0], in.dims[1], 1}, {}};
+  plane.vals.assign(in.vals.cbegin(), in.vals.cbegin() + plane_size);
+  return plane;
+}
+
+auto forward_xform(const Input& in) -> sperr::vecd_type
+{
+  auto cdf = sperr::CDF97<double>();
+  cdf.copy_data(in.vals.data(), in.vals.size(), in.dims);
+  if (in.dims[1] == 1)
+    cdf.dwt1d();
+  else if (in.dims[2] == 1)
+    cdf.dwt2d();
+  else
+    cdf.dwt3d();
+  return cdf.release_data();
+}
+
+// Quantize wavelet coefficients so that the biggest magnitude is 200, which fits in every
+//    integer width, so that different widths encode the same bitplanes.
+template <typename T>
+auto make_ints(const sperr::vecd_type& coeffs) -> std::pair<std::vector<T>, sperr::Bitmask>
+{
+  const auto maxd = std::abs(*std::max_element(
+      coeffs.cbegin(), coeffs.cend(), [](auto a, auto b) { return std::abs(a) < std::abs(b); }));
+  const auto inv = maxd > 0.0 ? 200.0 / maxd : 0.0;
+  auto ints = std::vector<T>(coeffs.size());
+  auto signs = sperr::Bitmask(coeffs.size());
+  for (size_t i = 0; i < coeffs.size(); i++) {
+    ints[i] = static_cast<T>(std::llrint(std::abs(coeffs[i]) * inv));
+    signs.wbit(i, coeffs[i] >= 0.0);
+  }
+  return {std::move(ints), std::move(signs)};
+}
+
+// Exposes the quantization steps of SPECK_FLT.
+class Quantizer : public sperr::SPECK3D_FLT {
+ public:
+  void use_coeffs(const sperr::vecd_type& coeffs, double q)
+  {
+    m_vals_d = coeffs;
+    m_q = q;
+  }
+  auto quantize() -> sperr::RTNType { return m_midtread_quantize(); }
+  void inverse_quantize() { m_midtread_inv_quantize(); }
+};
+
+void set_counters(benchmark::State& state, size_t num_vals)
+{
+  state.SetItemsProcessed(state.iterations() * num_vals);
+  state.SetBytesProcessed(state.iterations() * num_vals * sizeof(double));
+}
+
+//
+// CDF97
+//
+void bench_dwt(benchmark::State& state, const Input& in, bool inverse)
+{
+  if (in.vals.empty()) {
+    state.SkipWithError("no input data");
+    return;
+  }
+  const auto& src = inverse ? forward_xform(in) : in.vals;
+  auto cdf = sperr::CDF97<double>();
+  for (auto _ : state) {
+    state.PauseTiming();
+    cdf.copy_data(src.data(), src.size(), in.dims);
+    state.ResumeTiming();
+    if (in.dims[1] == 1)
+      inverse ? cdf.idwt1d() : cdf.dwt1d();
+    else if (in.dims[2] == 1)
+      inverse ? cdf.idwt2d() : cdf.dwt2d();
+    else
+      inverse ? cdf.idwt3d() : cdf.dwt3d();
+    benchmark::DoNotOptimize(cdf.view_data().data());
+  }
+  set_counters(state, src.size());
+}
+
+//
+// Conditioner
+//
+void bench_condition(benchmark::State& state, const Input& in)
+{
+  if (in.vals.empty()) {
+    state.SkipWithError("no input data");
+    return;
+  }
+  auto condi = sperr::Conditioner();
+  auto buf = sperr::vecd_type();
+  for (auto _ : state) {
+    state.PauseTiming();
+    buf = in.vals;
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(condi.condition(buf, in.dims));
+  }
+  set_counters(state, in.vals.size());
+}
+
+//
+// SPECK_FLT quantization
+//
+void bench_quantize(benchmark::State& state, const Input& in, bool inverse)
+{
+  if (in.vals.empty()) {
+    state.SkipWithError("no input data");
+    return;
+  }
+  const auto coeffs = forward_xform(in);
+  const auto maxd = std::abs(*std::max_element(
+      coeffs.cbegin(), coeffs.cend(), [](auto a, auto b) { return std::abs(a) < std::abs(b); }));
+  const auto q = maxd / 2000.0;  // Results in 16-bit integers.
+
+  auto quant = Quantizer();
+  quant.use_coeffs(coeffs, q);
+  quant.quantize();
+  for (auto _ : state) {
+    if (inverse)
+      quant.inverse_quantize();
+    else {
+      state.PauseTiming();
+      quant.use_coeffs(coeffs, q);
+      state.ResumeTiming();
+      benchmark::DoNotOptimize(quant.quantize());
+    }
+  }
+  set_counters(state, coeffs.size());
+}
+
+//
+// SPECK{1,2,3}D_INT
+//
+template <typename Enc, typename Dec, typename T>
+void bench_speck_int(benchmark::State& state, const Input& in, bool decode)
+{
+  if (in.vals.empty()) {
+    state.SkipWithError("no input data");
+    return;
+  }
+  const auto [ints, signs] = make_ints<T>(forward_xform(in));
+
+  auto encoder = Enc();
+  encoder.set_dims(in.dims);
+  encoder.use_coeffs(ints, signs);
+  encoder.encode();
+  auto stream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(stream);
+
+  auto decoder = Dec();
+  decoder.set_dims(in.dims);
+  for (auto _ : state) {
+    if (decode) {
+      decoder.use_bitstream(stream.data(), stream.size());
+      decoder.decode();
+      benchmark::DoNotOptimize(decoder.view_coeffs().data());
+    }
+    else {
+      state.PauseTiming();
+      encoder.use_coeffs(ints, signs);
+      state.ResumeTiming();
+      encoder.encode();
+      benchmark::DoNotOptimize(encoder.encoded_bitstream_len());
+    }
+  }
+  set_counters(state, ints.size());
+  state.counters["bpp"] = double(stream.size() * 8) / double(ints.size());
+}
+
+template <typename T>
+void register_speck_int(const Input& in, const std::string& width)
+{
+  using namespace sperr;
+  const auto suffix = "/" + width + "/" + in.name;
+  const auto ref = std::cref(in);
+  if (in.dims[1] == 1) {
+    using Enc = SPECK1D_INT_ENC<T>;
+    using Dec = SPECK1D_INT_DEC<T>;
+    benchmark::RegisterBenchmark(("SPECK1D_INT/encode" + suffix).c_str(),
+                                 bench_speck_int<Enc, Dec, T>, ref, false);
+    benchmark::RegisterBenchmark(("SPECK1D_INT/decode" + suffix).c_str(),
+                                 bench_speck_int<Enc, Dec, T>, ref, true);
+  }
+  else if (in.dims[2] == 1) {
+    using Enc = SPECK2D_INT_ENC<T>;
+    using Dec = SPECK2D_INT_DEC<T>;
+    benchmark::RegisterBenchmark(("SPECK2D_INT/encode" + suffix).c_str(),
+                                 bench_speck_int<Enc, Dec, T>, ref, false);
+    benchmark::RegisterBenchmark(("SPECK2D_INT/decode" + suffix).c_str(),
+                                 bench_speck_int<Enc, Dec, T>, ref, true);
+  }
+  else {
+    using Enc = SPECK3D_INT_ENC<T>;
+    using Dec = SPECK3D_INT_DEC<T>;
+    benchmark::RegisterBenchmark(("SPECK3D_INT/encode" + suffix).c_str(),
+                                 bench_speck_int<Enc, Dec, T>, ref, false);
+    benchmark::RegisterBenchmark(("SPECK3D_INT/decode" + suffix).c_str(),
+                                 bench_speck_int<Enc, Dec, T>, ref, true);
+  }
+}
+
+//
+// Outlier_Coder
+//
+void bench_outlier(benchmark::State& state, const Input& in, bool decode)
+{
+  if (in.vals.empty()) {
+    state.SkipWithError("no input data");
+    return;
+  }
+
+  // 1% of the values are outliers, which is on the high end of what PWE mode sees.
+  const auto len = in.vals.size();
+  const double tol = 1e-3;
+  auto los = std::vector<sperr::Outlier>();
+  std::mt19937 gen{17};
+  std::uniform_real_distribution<double> val_d{tol, 10.0 * tol};
+  for (size_t i = 0; i < len; i += 100)
+    los.emplace_back(i, (i % 200 == 0) ? val_d(gen) : -val_d(gen));
+
+  auto encoder = sperr::Outlier_Coder();
+  encoder.set_length(len);
+  encoder.set_tolerance(tol);
+  encoder.use_outlier_list(los);
+  encoder.encode();
+  auto stream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(stream);
+
+  auto decoder = sperr::Outlier_Coder();
+  decoder.set_length(len);
+  decoder.set_tolerance(tol);
+  for (auto _ : state) {
+    if (decode) {
+      decoder.use_bitstream(stream.data(), stream.size());
+      benchmark::DoNotOptimize(decoder.decode());
+    }
+    else {
+      state.PauseTiming();
+      encoder.use_outlier_list(los);
+      state.ResumeTiming();
+      benchmark::DoNotOptimize(encoder.encode());
+    }
+  }
+  state.SetItemsProcessed(state.iterations() * los.size());
+}
+
+//
+// SPERR3D_OMP_C and SPERR3D_OMP_D, end to end
+//
+void bench_sperr3d(benchmark::State& state, const Input& in, bool decompress)
+{
+  if (in.vals.empty()) {
+    state.SkipWithError("no input data");
+    return;
+  }
+  const auto [minv, maxv] = std::minmax_element(in.vals.cbegin(), in.vals.cend());
+  const auto tol = (*maxv - *minv) * 1e-5;
+
+  auto compressor = sperr::SPERR3D_OMP_C();
+  compressor.set_num_threads(0);
+  compressor.set_dims_and_chunks(in.dims, {256, 256, 256});
+  compressor.set_tolerance(tol);
+  compressor.compress(in.vals.data(), in.vals.size());
+  const auto stream = compressor.get_encoded_bitstream();
+
+  auto decompressor = sperr::SPERR3D_OMP_D();
+  decompressor.set_num_threads(0);
+  for (auto _ : state) {
+    if (decompress) {
+      decompressor.use_bitstream(stream.data(), stream.size());
+      benchmark::DoNotOptimize(decompressor.decompress(stream.data()));
+    }
+    else
+      benchmark::DoNotOptimize(compressor.compress(in.vals.data(), in.vals.size()));
+  }
+  set_counters(state, in.vals.size());
+  state.counters["bpp"] = double(stream.size() * 8) / double(in.vals.size());
+}
+
+// Inputs live as long as the benchmarks that refer to them. Benchmarks hold references to the
+//    inputs instead of copies, so the containers aren't modified once benchmarks are registered.
+std::vector<Input> inputs_3d, inputs_2d, inputs_1d;
+
+void register_all()
+{
+  for (const auto* set : {&inputs_1d, &inputs_2d, &inputs_3d}) {
+    for (const auto& in : *set) {
+      const auto dim = (set == &inputs_1d) ? "1d" : (set == &inputs_2d) ? "2d" : "3d";
+      const auto suffix = std::string(dim) + "/" + in.name;
+      const auto ref = std::cref(in);
+      benchmark::RegisterBenchmark(("CDF97/dwt" + suffix).c_str(), bench_dwt, ref, false);
+      benchmark::RegisterBenchmark(("CDF97/idwt" + suffix).c_str(), bench_dwt, ref, true);
+      register_speck_int<uint8_t>(in, "u8");
+      register_speck_int<uint16_t>(in, "u16");
+      register_speck_int<uint32_t>(in, "u32");
+      register_speck_int<uint64_t>(in, "u64");
+    }
+  }
+
+  for (const auto& in : inputs_3d) {
+    const auto ref = std::cref(in);
+    benchmark::RegisterBenchmark(("Conditioner/condition/" + in.name).c_str(), bench_condition,
+                                 ref);
+    benchmark::RegisterBenchmark(("SPECK_FLT/quantize/" + in.name).c_str(), bench_quantize, ref,
+                                 false);
+    benchmark::RegisterBenchmark(("SPECK_FLT/inverse_quantize/" + in.name).c_str(),
+                                 bench_quantize, ref, true);
+    benchmark::RegisterBenchmark(("Outlier_Coder/encode/" + in.name).c_str(), bench_outlier, ref,
+                                 false);
+    benchmark::RegisterBenchmark(("Outlier_Coder/decode/" + in.name).c_str(), bench_outlier, ref,
+                                 true);
+    benchmark::RegisterBenchmark(("SPERR3D_OMP_C/compress/" + in.name).c_str(), bench_sperr3d,
+                                 ref, false);
+    benchmark::RegisterBenchmark(("SPERR3D_OMP_D/decompress/" + in.name).c_str(),
+                                 bench_sperr3d, ref, true);
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  // Take out the flags of this program, and leave the rest to Google Benchmark.
+  auto dims = sperr::dims_type{128, 128, 128};
+  auto data_dir = std::string(SPERR_TEST_DATA_DIR);
+  auto has_out = false;
+  auto args = std::vector<char*>();
+  for (int i = 0; i < argc; i++) {
+    const auto arg = std::string(argv[i]);
+    if (arg.rfind("--sperr_dims=", 0) == 0) {
+      const auto n = std::sscanf(arg.c_str(), "--sperr_dims=%zu,%zu,%zu", &dims[0], &dims[1],
+                                 &dims[2]);
+      if (n != 3 || dims[0] * dims[1] * dims[2] == 0) {
+        std::cerr << "Invalid dimension: " << arg << std::endl;
+        return 1;
+      }
+    }
+    else if (arg.rfind("--sperr_data_dir=", 0) == 0)
+      data_dir = arg.substr(std::strlen("--sperr_data_dir="));
+    else {
+      has_out = has_out || arg.rfind("--benchmark_out=", 0) == 0;
+      args.push_back(argv[i]);
+    }
+  }
+  auto json_out = std::string("--benchmark_out=sperr_bench.json");
+  auto json_fmt = std::string("--benchmark_out_format=json");
+  if (!has_out) {
+    args.push_back(json_out.data());
+    args.push_back(json_fmt.data());
+  }
+
+  // 3D inputs, the first planes of them and a 2D image, and the 3D inputs taken as 1D arrays.
+  inputs_3d.push_back(make_synthetic(dims));
+  inputs_3d.push_back(read_input(data_dir, "vorticity.128_128_41", {128, 128, 41}));
+  for (const auto& in : inputs_3d) {
+    if (in.dims[2] > 1 && !in.vals.empty())
+      inputs_2d.push_back(first_plane(in));
+    inputs_1d.push_back({in.name, {in.vals.size(), 1, 1}, in.vals});
+  }
+  inputs_2d.push_back(read_input(data_dir, "lena512.float", {512, 512, 1}));
+  if (dims[2] == 1) {
+    inputs_2d.push_back(std::move(inputs_3d.front()));
+    inputs_3d.erase(inputs_3d.begin());
+  }
+
+  register_all();
+
+  int bench_argc = static_cast<int>(args.size());
+  benchmark::Initialize(&bench_argc, args.data());
+  if (benchmark::ReportUnrecognizedArguments(bench_argc, args.data()))
+    return 1;
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+
+  return 0;
+}
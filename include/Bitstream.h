@@ -28,6 +28,7 @@
  *      a Bitstream itself will lose track of how many useful bits are there after flush().
  *   7. Unlike std::vector, a bitstream does NOT have an equivalent concept of "size."
  *      Thus, capacity change brought by `reserve()` can be immediately used to read/write.
+ *   8. wbits() requires the bits beyond `nbits` in its input to be all 0's.
  */
 
 #include <cstddef>
@@ -54,12 +55,14 @@ class Bitstream {
   auto rtell() const -> size_t;
   void rseek(size_t offset);
   auto rbit() -> bool;
+  auto rbits(size_t nbits) -> uint64_t;  // Read `nbits` (<= 64) bits, the first one in the LSB.
 
   // Functions for write
   //
   auto wtell() const -> size_t;
   void wseek(size_t offset);
   void wbit(bool bit);
+  void wbits(uint64_t bits, size_t nbits);  // Same as `nbits` (<= 64) wbit() calls, LSB first.
   void flush();
 
   // Functions that provide or parse a compact bitstream
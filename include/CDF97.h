@@ -1,10 +1,14 @@
 //
-// Four member functions are heavily based on QccPack:
+// The lifting steps are heavily based on the following functions from QccPack:
 //    http://qccpack.sourceforge.net/index.shtml
-//  - void QccWAVCDF97AnalysisSymmetricEvenEven(double* signal, size_t signal_length);
-//  - void QccWAVCDF97AnalysisSymmetricOddEven(double* signal, size_t signal_length);
-//  - void QccWAVCDF97SynthesisSymmetricEvenEven(double* signal, size_t signal_length);
-//  - void QccWAVCDF97SynthesisSymmetricOddEven(double* signal, size_t signal_length);
+//  - QccWAVCDF97AnalysisSymmetricEvenEven() and QccWAVCDF97AnalysisSymmetricOddEven()
+//  - QccWAVCDF97SynthesisSymmetricEvenEven() and QccWAVCDF97SynthesisSymmetricOddEven()
+// They're carried out by the fused kernels in CDF97_Kernels.cpp, which produce bit-identical
+//    results as these functions.
+//
+// The class is templated on the floating-point type that the transforms are carried out in:
+//    `CDF97<double>` is what the SPERR compressors use, and `CDF97<float>` halves the memory
+//    footprint and bandwidth of transforms on single-precision data at the cost of round-off.
 //
 
 #ifndef CDF97_H
@@ -16,23 +20,79 @@
 
 namespace sperr {
 
+// Everything about the wavelet decomposition of a volume that's determined by its dimension
+//    alone. Chunks of a volume mostly share a few dimensions, so their plans are made once and
+//    shared by all CDF97 objects working on these chunks (see `CDF97::use_plan()`).
+struct DWT_Plan {
+  dims_type dims = {0, 0, 0};
+  std::optional<size_t> dyadic;  // Levels of dyadic decomposition, if it can be used.
+  size_t xforms_x = 0;           // Levels of 1D transforms.
+  size_t xforms_xy = 0;          // Levels on XY planes, in 2D and wavelet packet transforms.
+  size_t xforms_z = 0;           // Levels on Z columns, in wavelet packet transforms.
+  size_t max_col = 0;            // Length of the longest column, which sizes scratch buffers.
+
+  // Approximation lengths in X, Y, and Z at every level, from the native resolution (level 0)
+  //    to the coarsest level of all transforms above.
+  std::vector<dims_type> approx;
+};
+
+auto make_dwt_plan(dims_type dims) -> std::shared_ptr<const DWT_Plan>;
+
+// Make one plan for every distinct dimension of chunks (from `sperr::chunk_volume()`).
+auto make_dwt_plans(const std::vector<std::array<size_t, 6>>& chunks)
+    -> std::vector<std::shared_ptr<const DWT_Plan>>;
+
+template <typename T>
+class CDF97_Stream;
+
+template <typename T>
 class CDF97 {
+  // Streaming transforms reuse the one-level transforms and the lifting kernels.
+  friend class CDF97_Stream<T>;
+
  public:
   //
   // Input
   //
   // Note that copy_data() and take_data() effectively resets internal states of this class.
-  template <typename T>
-  auto copy_data(const T* buf, size_t len, dims_type dims) -> RTNType;
-  auto take_data(vecd_type&& buf, dims_type dims) -> RTNType;
+  template <typename U>
+  auto copy_data(const U* buf, size_t len, dims_type dims) -> RTNType;
+  auto take_data(vec_type<T>&& buf, dims_type dims) -> RTNType;
 
   //
   // Output
   //
-  auto view_data() const -> const vecd_type&;
-  auto release_data() -> vecd_type&&;
+  auto view_data() const -> const vec_type<T>&;
+  auto release_data() -> vec_type<T>&&;
   auto get_dims() const -> std::array<size_t, 3>;  // In 2D case, the 3rd value equals 1.
 
+  //
+  // Instruction set used by the lifting kernels
+  //
+  // By default, the most capable instruction set of the current machine is used. Results are
+  //    bit-identical no matter which instruction set is used. `set_isa()` returns an error if
+  //    the requested instruction set isn't supported by the machine (or the build).
+  auto set_isa(ISAType) -> RTNType;
+  auto get_isa() const -> ISAType;
+
+  // Z columns of a volume are copied to a contiguous block and transformed together in tiles
+  //    of (tile[0] x tile[1]) columns along X and Y. The tile size doesn't affect the results.
+  void set_z_tile(std::array<size_t, 2> tile);
+  auto get_z_tile() const -> std::array<size_t, 2>;
+
+  // Rows, columns, and tiles of Z columns within one level of transform are independent, so
+  //    they're split across `n` threads (OpenMP), each with its own scratch buffers. If 0 is
+  //    passed in, the maximal number of threads will be used. The number of threads doesn't
+  //    affect the results. Without OpenMP (option USE_OMP), the transforms are always serial.
+  void set_num_threads(size_t n);
+  auto get_num_threads() const -> size_t;
+
+  // Plans are kept for the last few dimensions of data passed in, so that a new plan is made
+  //    only for a dimension that hasn't been seen recently. `use_plan()` adds a plan made
+  //    elsewhere (by `make_dwt_plan()`), so that it's shared rather than made again. Data
+  //    of this dimension passed in later will use it.
+  void use_plan(std::shared_ptr<const DWT_Plan> plan);
+
   //
   // Action items
   //
@@ -53,12 +113,26 @@ class CDF97 {
   //    still be retrieved by the `view_data()` or `release_data()` functions.
   //    If multi-resolution is not supported, then it simply returns an empty vector, with the
   //    decompression still performed, and the native resolution reconstruction ready.
+  //    Note: coarsened volumes are always in double precision.
   [[nodiscard]] auto idwt2d_multi_res() -> std::vector<vecd_type>;
   void idwt3d_multi_res(std::vector<vecd_type>&);
 
+  //
+  // Region-of-interest reconstruction
+  //
+
+  // Reconstruct only a box of the volume from the wavelet coefficients produced by `dwt3d()`.
+  //    The box is specified the same way as a chunk from `sperr::chunk_volume()`: box[0], [2],
+  //    and [4] are its starting indices in X, Y, and Z, and box[1], [3], and [5] are its lengths.
+  //    At every level, only the coefficients whose filter support reaches the box are inverse
+  //    transformed, so the cost scales with the size of the box rather than the whole volume.
+  //    The returned values are bit-identical to the same box of a full `idwt3d()`, and the
+  //    coefficients held by this object are left intact.
+  //    It returns an empty vector if the box is empty or doesn't fit in the volume.
+  [[nodiscard]] auto idwt3d_region(std::array<size_t, 6> box) const -> vec_type<T>;
+
  private:
-  using itd_type = vecd_type::iterator;
-  using citd_type = vecd_type::const_iterator;
+  using itd_type = typename vec_type<T>::iterator;
 
   //
   // Private methods helping DWT.
@@ -78,29 +152,20 @@ class CDF97 {
   void m_dwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz);
   void m_idwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz);
 
+  // Multiple levels of dwt/idwt on all Z columns of a given volume (m_dims),
+  // specifically on its top left (len_xyz) subset. Columns are processed in tiles (m_z_tile).
+  void m_dwt_z(itd_type vol, std::array<size_t, 3> len_xyz, size_t num_of_xforms);
+  void m_idwt_z(itd_type vol, std::array<size_t, 3> len_xyz, size_t num_of_xforms);
+
   // Perform one level of 2D dwt/idwt on a given plane (m_dims),
   // specifically on its top left (len_xy) subset.
   void m_dwt2d_one_level(itd_type plane, std::array<size_t, 2> len_xy);
   void m_idwt2d_one_level(itd_type plane, std::array<size_t, 2> len_xy);
 
   // Perform one level of 1D dwt/idwt on a given array (array_len).
-  // A buffer space (tmp_buf) should be passed in for
-  // this method to work on with length at least 2*array_len.
   void m_dwt1d_one_level(itd_type array, size_t array_len);
   void m_idwt1d_one_level(itd_type array, size_t array_len);
 
-  // Separate even and odd indexed elements to be at the front and back of the dest array.
-  // Note 1: sufficient memory space should be allocated by the caller.
-  // Note 2: two versions for even and odd length input.
-  void m_gather_even(citd_type begin, citd_type end, itd_type dest) const;
-  void m_gather_odd(citd_type begin, citd_type end, itd_type dest) const;
-
-  // Interleave low and high pass elements to be at even and odd positions of the dest array.
-  // Note 1: sufficient memory space should be allocated by the caller.
-  // Note 2: two versions for even and odd length input.
-  void m_scatter_even(citd_type begin, citd_type end, itd_type dest) const;
-  void m_scatter_odd(citd_type begin, citd_type end, itd_type dest) const;
-
   // Two flavors of 3D transforms.
   // They should be invoked by the `dwt3d()` and `idwt3d()` public methods, not users, though.
   void m_dwt3d_wavelet_packet();
@@ -108,32 +173,53 @@ class CDF97 {
   void m_dwt3d_dyadic(size_t num_xforms);
   void m_idwt3d_dyadic(size_t num_xforms);
 
+  // Reconstruct `box` (specified the same way as in `idwt3d_region()`) of a volume `src` of
+  //    dimension `src_dims`, which went through `num_xforms` levels of transform along the axes
+  //    flagged by `axes`. Supported axes are {X, Y, Z} (dyadic), {X, Y} (planes), and {Z}.
+  auto m_idwt_region(const T* src,
+                     dims_type src_dims,
+                     std::array<size_t, 6> box,
+                     std::array<bool, 3> axes,
+                     size_t num_xforms) const -> vec_type<T>;
+
   // Extract a sub-slice/sub-volume starting with the same origin of the full slice/volume.
   // It is UB if `subdims` exceeds the full dimension (`m_dims`).
   // It is UB if `dst` does not point to a big enough space.
   auto m_sub_slice(std::array<size_t, 2> subdims) const -> vecd_type;
-  void m_sub_volume(dims_type subdims, itd_type dst) const;
+  void m_sub_volume(dims_type subdims, vecd_type::iterator dst) const;
 
-  //
-  // Methods from QccPack, so keep their original names, interface, and the use of raw pointers.
-  //
-  void QccWAVCDF97AnalysisSymmetricEvenEven(double* signal, size_t signal_length);
-  void QccWAVCDF97AnalysisSymmetricOddEven(double* signal, size_t signal_length);
-  void QccWAVCDF97SynthesisSymmetricEvenEven(double* signal, size_t signal_length);
-  void QccWAVCDF97SynthesisSymmetricOddEven(double* signal, size_t signal_length);
+  // Set `m_dims`, and update `m_plan` to one of this dimension.
+  void m_set_dims(dims_type dims);
+
+  // Make sure that each thread has scratch buffers big enough for the current dimension.
+  void m_alloc_scratch();
 
   //
   // Private data members
   //
-  vecd_type m_data_buf;          // Holds the entire input data.
+  vec_type<T> m_data_buf;        // Holds the entire input data.
   dims_type m_dims = {0, 0, 0};  // Dimension of the data volume
 
-  // Temporary buffers that are big enough for any (1D column * 2) or any 2D
-  // slice. Note: `m_qcc_buf` should be used by m_***_one_level() functions and
-  // should not be used by higher-level functions. `m_slice_buf` is only used by
-  // wavelet-packet transforms.
-  vecd_type m_qcc_buf;
-  vecd_type m_slice_buf;
+  // Plan of `m_dims`, and plans of the last few dimensions.
+  static constexpr size_t MAX_PLANS = 8;
+  std::shared_ptr<const DWT_Plan> m_plan = sperr::make_dwt_plan(m_dims);
+  std::vector<std::shared_ptr<const DWT_Plan>> m_plans;
+
+  size_t m_num_threads = 1;
+
+  // One temporary buffer per thread that is big enough for any (1D column * 2).
+  // Note: `m_qcc_buf` should be used by m_***_one_level() functions and
+  // should not be used by higher-level functions.
+  std::vector<vec_type<T>> m_qcc_buf;
+
+  // Number of columns that are transformed together by the lifting kernels in a
+  // 2D Y pass, and one buffer per thread to hold these columns. The buffers also hold tiles
+  // of Z columns in m_dwt_z() and m_idwt_z(), which grow them as needed.
+  static constexpr size_t LANES = 16;
+  std::vector<vec_type<T>> m_lane_buf;
+  std::array<size_t, 2> m_z_tile = {64, 1};
+
+  ISAType m_isa = sperr::best_isa();
 
   //
   // Note on the coefficients and constants:
@@ -146,19 +232,19 @@ class CDF97 {
   // (https://services.math.duke.edu/~ingrid/publications/CPAM_1992_p485.pdf)
   //
 
-  // Paper coefficients
+  // Paper coefficients (they're always calculated in double precision)
   const std::array<double, 5> h = {0.602949018236, 0.266864118443, -0.078223266529, -0.016864118443,
                                    0.026748757411};
   const double r0 = h[0] - 2.0 * h[4] * h[1] / h[3];
   const double r1 = h[2] - h[4] - h[4] * h[1] / h[3];
   const double s0 = h[1] - h[3] - h[3] * r0 / r1;
   const double t0 = h[0] - 2.0 * (h[2] - h[4]);
-  const double ALPHA = h[4] / h[3];
-  const double BETA = h[3] / r1;
-  const double GAMMA = r1 / s0;
-  const double DELTA = s0 / t0;
-  const double EPSILON = std::sqrt(2.0) * t0;
-  const double INV_EPSILON = 1.0 / EPSILON;
+  const T ALPHA = static_cast<T>(h[4] / h[3]);
+  const T BETA = static_cast<T>(h[3] / r1);
+  const T GAMMA = static_cast<T>(r1 / s0);
+  const T DELTA = static_cast<T>(s0 / t0);
+  const T EPSILON = static_cast<T>(std::sqrt(2.0) * t0);
+  const T INV_EPSILON = static_cast<T>(1.0 / (std::sqrt(2.0) * t0));
 
   // QccPack coefficients
   //
@@ -0,0 +1,67 @@
+//
+// Lifting kernels that perform the bulk of work in the CDF97 class.
+//
+// Each kernel carries out all lifting steps of one level of transform in a single sweep, and
+//    reads and writes the low and high pass bands separately, so that no separate pass is
+//    needed to gather or scatter them.
+//
+// Kernels written for different instruction sets perform the same floating-point operations
+//    in the same order, so they produce bit-identical results.
+//
+// Note: this header is used internally by CDF97.cpp, and is not installed.
+//
+
+#ifndef CDF97_KERNELS_H
+#define CDF97_KERNELS_H
+
+#include "sperr_helper.h"
+
+namespace sperr {
+
+// Lifting coefficients, which are kept in the CDF97 class.
+template <typename T>
+struct LiftingCoeffs {
+  T alpha, beta, gamma, delta, epsilon, inv_epsilon;
+};
+
+template <typename T>
+struct LiftingKernels {
+  // One level of analysis (forward transform) on `lanes` signals of length `len`, with all
+  //    lifting steps fused in a single sweep. Element i of the input starts from
+  //    `src + i * src_stride`, and holds `lanes` contiguous values, one from each signal.
+  //    The k-th low and high pass results are written to
+  //    `low + k * low_stride` and `high + k * high_stride`, respectively. `low` may be the
+  //    same as `src` (with the same stride), but `high` can't overlap `src`.
+  void (*analysis)(const T* src,
+                   size_t src_stride,
+                   T* low,
+                   size_t low_stride,
+                   T* high,
+                   size_t high_stride,
+                   size_t len,
+                   size_t lanes,
+                   const LiftingCoeffs<T>& c);
+
+  // One level of synthesis (inverse transform), the reverse of `analysis`. `dst` may be
+  //    the same as `high - num_of_low * high_stride`, i.e., the low and high pass results
+  //    are stored together and transformed in place, as long as the low pass results are
+  //    read from a separate copy.
+  void (*synthesis)(const T* low,
+                    size_t low_stride,
+                    const T* high,
+                    size_t high_stride,
+                    T* dst,
+                    size_t dst_stride,
+                    size_t len,
+                    size_t lanes,
+                    const LiftingCoeffs<T>& c);
+};
+
+// Retrieve the set of kernels written for an instruction set, on either float or double.
+//    It is UB if the instruction set isn't supported (see `sperr::isa_supported()`).
+template <typename T>
+auto lifting_kernels(ISAType) -> const LiftingKernels<T>&;
+
+};  // namespace sperr
+
+#endif
@@ -0,0 +1,105 @@
+//
+// Streaming 3D wavelet transform that consumes a volume one Z slab at a time.
+//
+// It produces the same coefficients as `CDF97::dwt3d()`, bit-identically, but only keeps a
+//    sliding window of planes at every level, i.e., the planes that the 9/7 filter support
+//    reaches from the next batch of Z coefficients. The peak memory footprint is thus
+//    proportional to a slab of planes rather than the whole volume.
+//
+// Finished coefficients are emitted as slabs, each covering the top-left part of one plane of
+//    the coefficient volume, and every coefficient is finished by exactly one slab. With dyadic
+//    decomposition, a low pass plane of one level is emitted with a hole in its top-left part,
+//    which the next level transforms further and emits in its own slabs.
+//
+// Z columns are transformed by the lifting kernels of CDF97 in windows of `BATCH` output
+//    pairs. Neighboring windows overlap by the radius of the lifting steps, and only
+//    coefficients outside the overlap are kept, so artificial boundaries never show up.
+//
+
+#ifndef CDF97_STREAM_H
+#define CDF97_STREAM_H
+
+#include "CDF97.h"
+
+#include <deque>
+
+namespace sperr {
+
+template <typename T>
+class CDF97_Stream {
+ public:
+  // The top-left part (len_xy) of plane `z` of the coefficient volume, except for a hole in its
+  //    own top-left part (hole_xy). Values in the hole are not finished, and should be skipped.
+  struct Slab {
+    size_t z = 0;
+    std::array<size_t, 2> len_xy = {0, 0};
+    std::array<size_t, 2> hole_xy = {0, 0};
+    vec_type<T> vals;
+  };
+
+  // Same as `CDF97::set_isa()` and `CDF97::set_num_threads()`.
+  auto set_isa(ISAType) -> RTNType;
+  void set_num_threads(size_t n);
+
+  // Start transforming a new volume of dimension `dims`, discarding any unfinished one.
+  void start(dims_type dims);
+
+  // Transform the next `num_planes` XY planes of the volume, which are in the order of Z.
+  //    It returns an error if more planes than the volume has are passed in.
+  template <typename U>
+  auto push(const U* planes, size_t num_planes) -> RTNType;
+
+  // Slabs finished since the last call. Release them after every `push()` to keep the memory
+  //    footprint bounded.
+  [[nodiscard]] auto release_slabs() -> std::vector<Slab>;
+
+  // Tell if all planes of the volume have been pushed and transformed.
+  auto finished() const -> bool;
+
+ private:
+  // One level of transform along Z, which receives the low pass planes of the previous level
+  //    (or the input planes) and keeps the ones still needed by the unfinished Z coefficients.
+  struct Level {
+    size_t len = 0;                         // Length of the Z columns at this level.
+    std::array<size_t, 2> len_xy = {0, 0};  // Part of every plane transformed along Z.
+    size_t received = 0;                    // Number of planes received.
+    size_t next = 0;                        // Next pair of Z coefficients to produce.
+    size_t first = 0;                       // Z index of `planes.front()`.
+    std::deque<vec_type<T>> planes;
+
+    // Scratch buffers of a window of planes, and its low and high pass results. Every level
+    //    has its own, because producing coefficients of one level feeds the next level.
+    vec_type<T> window, low, high;
+  };
+
+  // Pass a plane to level `lev`, and produce as many Z coefficients there as possible.
+  void m_feed(size_t lev, vec_type<T>&& plane);
+
+  // Produce Z coefficient pairs [k0, k1) of level `lev`, and hand them over.
+  void m_produce(size_t lev, size_t k0, size_t k1);
+
+  // Emit plane `z` of the coefficient volume, whose top-left (len_xy) part is finished by the
+  //    Z transforms, except for the hole (hole_xy). With wavelet packet decomposition, XY
+  //    transforms are still to be applied.
+  void m_finish(size_t z,
+                std::array<size_t, 2> len_xy,
+                std::array<size_t, 2> hole_xy,
+                vec_type<T>&& plane);
+
+  // Number of Z coefficient pairs produced from every window of planes.
+  static constexpr size_t BATCH = 16;
+
+  // Radius of the 4 lifting steps, which is also how far artificial boundaries reach.
+  static constexpr size_t RADIUS = 4;
+
+  CDF97<T> m_cdf;  // Transforms XY planes, and provides the lifting kernels.
+  dims_type m_dims = {0, 0, 0};
+  std::optional<size_t> m_dyadic;
+  size_t m_received = 0;
+  std::vector<Level> m_levels;
+  std::vector<Slab> m_slabs;
+};
+
+};  // namespace sperr
+
+#endif
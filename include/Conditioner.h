@@ -19,11 +19,17 @@ class Conditioner {
 
   auto is_constant(uint8_t) const -> bool;
 
+  // Flag (or query) that the coefficients are coded in independent code blocks.
+  //    The conditioner itself doesn't use this flag; it only carries it in the header.
+  void mark_code_blocks(condi_type& header, bool) const;
+  auto has_code_blocks(uint8_t) const -> bool;
+
   // Save a double to the last 8 bytes of a condi_type.
   void save_q(condi_type& header, double q) const;
   auto retrieve_q(condi_type header) const -> double;
 
  private:
+  const size_t m_code_blocks_idx = 1;
   const size_t m_constant_field_idx = 7;
   const size_t m_default_num_strides = 2048;
 
@@ -0,0 +1,44 @@
+//
+// Kernels that quantize wavelet coefficients to integers, and back, in the SPECK_FLT class.
+//
+// Quantization rounds every value to its nearest integer (ties to even, the same as
+//    `std::llrint()` in the default rounding mode), keeps the magnitude as an unsigned integer,
+//    and records whether the rounded integer is non-negative in a Bitmask.
+//    Kernels written for different instruction sets produce identical results.
+//
+// Note: this header is used internally by SPECK_FLT.cpp, and is not installed.
+//
+
+#ifndef QUANTIZE_KERNELS_H
+#define QUANTIZE_KERNELS_H
+
+#include "Bitmask.h"
+#include "sperr_helper.h"
+
+namespace sperr {
+
+// `T` is the unsigned integer type that holds quantized magnitudes.
+template <typename T>
+struct QuantizeKernels {
+  // Quantize `len` values with `inv_q`, the reciprocal of the quantization step, writing the
+  //    magnitudes to `ints`, and the signs to the first `len` bits of `signs`.
+  //    Every magnitude needs to fit in `T`.
+  void (*quantize)(const double* vals, size_t len, double inv_q, T* ints, Bitmask& signs);
+
+  // The reverse of `quantize`: write every signed integer multiplied by `q` to `vals`.
+  void (*inv_quantize)(const T* ints, const Bitmask& signs, size_t len, double q, double* vals);
+};
+
+// Retrieve the set of kernels written for an instruction set, on one integer type.
+//    It is UB if the instruction set isn't supported (see `sperr::isa_supported()`).
+//    The SIMD kernels on uint64_t are the scalar ones, as neither AVX2 nor AVX-512F converts
+//    between double and 64-bit integers.
+template <typename T>
+auto quantize_kernels(ISAType) -> const QuantizeKernels<T>&;
+
+// The biggest magnitude of `len` values, found with the kernel of an instruction set.
+auto max_magnitude(const double* vals, size_t len, ISAType) -> double;
+
+};  // namespace sperr
+
+#endif
@@ -63,6 +63,8 @@ class SPECK1D_INT : public SPECK_INT<T> {
 
   auto m_partition_set(Set1D) const -> std::array<Set1D, 2>;
 
+  virtual void m_additional_initialization() {};  // empty by default
+
   //
   // SPECK1D_INT specific data members
   //
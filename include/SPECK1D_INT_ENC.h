@@ -13,6 +13,12 @@ namespace sperr {
 template <typename T>
 class SPECK1D_INT_ENC final : public SPECK1D_INT<T> {
  private:
+  //
+  // Consistant with the base class.
+  //
+  using uint_type = T;
+  using vecui_type = std::vector<uint_type>;
+
   //
   // Bring members from parent classes to this derived class.
   //
@@ -26,6 +32,7 @@ class SPECK1D_INT_ENC final : public SPECK1D_INT<T> {
   using SPECK1D_INT<T>::m_partition_set;
 
   void m_sorting_pass() final;
+  void m_additional_initialization() final;
 
   void m_process_S(size_t idx1, size_t idx2, SigType, size_t& counter, bool output);
   void m_process_P(size_t idx, SigType, size_t& counter, bool output);
@@ -34,6 +41,18 @@ class SPECK1D_INT_ENC final : public SPECK1D_INT<T> {
   // Decide if a set is significant or not.
   // If it is significant, also identify the point that makes it significant.
   auto m_decide_significance(const Set1D&) const -> std::optional<size_t>;
+
+  // A hierarchy of block maximums over `m_coeff_buf`: every value of level `l` is the maximum
+  //    of `BLOCK` consecutive values of level `l - 1`, with `m_coeff_buf` itself being level 0.
+  //    It lets the search for the first significant point skip whole blocks of insignificant
+  //    values, which is what long and sparse inputs (e.g., outliers) mostly consist of.
+  //    The maximums stay exact for every set being decided, because a point is only modified
+  //    after it becomes significant, and none of the sets in LIS contains a significant point.
+  static constexpr size_t BLOCK = 64;
+  std::vector<vecui_type> m_block_max;
+
+  // Find the first point of level `lev` in the range of [lo, hi) that is significant.
+  auto m_find_significant(size_t lev, size_t lo, size_t hi) const -> std::optional<size_t>;
 };
 
 };  // namespace sperr
@@ -7,8 +7,8 @@ namespace sperr {
 
 class SPECK2D_FLT : public SPECK_FLT {
  protected:
-  void m_instantiate_encoder() override;
-  void m_instantiate_decoder() override;
+  void m_instantiate_encoder(speck_int_ptr&) override;
+  void m_instantiate_decoder(speck_int_ptr&) override;
 
   void m_wavelet_xform() override;
   void m_inverse_wavelet_xform(bool) override;
@@ -37,8 +37,25 @@ class SPECK3D_INT_ENC final : public SPECK3D_INT<T> {
   void m_additional_initialization() final;
 
   // Data structures and functions for morton data layout.
+  //    The morton order is made of small blocks (of 1, 2, 4, or 8 elements), each of which is
+  //    recorded as its raster index (shifted left by 3) and the axes it spans (bits 0, 1, 2 for
+  //    X, Y, Z). Chunks of a volume mostly share a dimension, so the blocks are listed once for
+  //    a dimension, and every chunk is then laid out by a single pass over them.
   vecui_type m_morton_buf;
-  void m_deposit_set(Set3D);
+  dims_type m_blocks_dims = {0, 0, 0};
+  std::vector<uint64_t> m_blocks;
+  void m_list_blocks(Set3D);
+  void m_deposit_blocks();
+
+  // The maximum magnitude of every set of the octree partition with more than `SCAN_LEN`
+  //    elements, so that its significance is decided by a single lookup instead of scanning all
+  //    of its elements again at every bitplane. Smaller sets are cheaper to scan.
+  //    A set is keyed by the morton offset of the first element of its second non-empty subset,
+  //    which no other set shares, so the maximums fit in an array the same size as the volume.
+  static constexpr size_t SCAN_LEN = 512;
+  vecui_type m_set_max;
+  auto m_set_max_idx(const Set3D&) const -> size_t;
+  auto m_record_max(Set3D) -> uint_type;  // Record (and return) the max of a deposited set.
 };
 
 };  // namespace sperr
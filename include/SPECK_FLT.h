@@ -10,6 +10,7 @@
 #include "Outlier_Coder.h"
 #include "SPECK_INT.h"
 
+#include <chrono>
 #include <variant>
 
 namespace sperr {
@@ -29,7 +30,8 @@ class SPECK_FLT {
   template <typename T>
   void copy_data(const T* p, size_t len);
 
-  // Accept incoming data: take ownership of a memory block
+  // Accept incoming data: take ownership of a memory block.
+  //    The memory block previously held is handed back in its place, so it can be reused.
   void take_data(std::vector<double>&&);
 
   // Use an encoded bitstream
@@ -54,6 +56,28 @@ class SPECK_FLT {
   void set_dims(dims_type);
   auto integer_len() const -> size_t;
 
+  // Number of threads used by wavelet transforms (1 by default). See `CDF97::set_num_threads()`.
+  //    When code blocks are enabled, the same number of threads also encodes/decodes them.
+  void set_xform_threads(size_t);
+
+  // Encode wavelet coefficients in independent code blocks (off by default), each with its own
+  //    SPECK_INT stream. Every axis longer than one is split in halves, so there are up to 8
+  //    blocks in 3D, which coincide with the subbands of the first level of wavelet transforms.
+  //    Blocks are encoded and decoded in parallel, and a length table is kept in the bitstream
+  //    so each block can be located (and truncated) on its own. It comes at the cost of
+  //    slightly bigger bitstreams, as the partitioning of every block starts from the scratch.
+  //    This setting is ignored in fixed-rate mode, which needs a single budget on the whole
+  //    stream. Decoders pick up this setting from the bitstream.
+  void set_code_blocks(bool);
+
+  // Share a wavelet transform plan with other encoders or decoders. See `CDF97::use_plan()`.
+  void use_dwt_plan(std::shared_ptr<const DWT_Plan>);
+
+  // Record the wall time spent in, and bytes produced by, every stage of `compress()` and
+  //    `decompress()` (off by default). The records start over at every call of them.
+  void enable_timing(bool);
+  auto view_timing() const -> const StageTimes&;
+
 #ifdef EXPERIMENTING
   void set_direct_q(double q);
 #endif
@@ -77,31 +101,52 @@ class SPECK_FLT {
   Bitmask m_sign_array;
   std::vector<vecd_type> m_hierarchy;  // multi-resolution decoding
 
-  CDF97 m_cdf;
+  CDF97<double> m_cdf;
+  size_t m_xform_threads = 1;
   Conditioner m_conditioner;
   Outlier_Coder m_out_coder;
 
+  bool m_timing = false;
+  StageTimes m_times;
+  std::chrono::steady_clock::time_point m_stage_start;
+
   std::variant<std::vector<uint8_t>,
                std::vector<uint16_t>,
                std::vector<uint32_t>,
                std::vector<uint64_t>>
       m_vals_ui;
 
-  std::variant<std::unique_ptr<SPECK_INT<uint8_t>>,
-               std::unique_ptr<SPECK_INT<uint16_t>>,
-               std::unique_ptr<SPECK_INT<uint32_t>>,
-               std::unique_ptr<SPECK_INT<uint64_t>>>
-      m_encoder, m_decoder;
+  using speck_int_ptr = std::variant<std::unique_ptr<SPECK_INT<uint8_t>>,
+                                     std::unique_ptr<SPECK_INT<uint16_t>>,
+                                     std::unique_ptr<SPECK_INT<uint32_t>>,
+                                     std::unique_ptr<SPECK_INT<uint64_t>>>;
+  speck_int_ptr m_encoder, m_decoder;
+
+  // Code block mode: one encoder or decoder for every block.
+  bool m_code_blocks = false;  // encoding only; decoding follows the bitstream.
+  std::vector<speck_int_ptr> m_block_encoders, m_block_decoders;
+
+  // Start timing a stage, and finish it with the number of bytes it produced.
+  //    They do nothing unless timing is enabled.
+  void m_start_stage();
+  void m_end_stage(StageType, size_t num_bytes);
 
   // Instantiate `m_vals_ui` based on the chosen integer length.
   void m_instantiate_int_vec();
 
-  // Derived classes instantiate the correct `m_encoder` and `m_decoder` depending on
-  // 3D/2D/1D classes, and on the integer length in use.
-  virtual void m_instantiate_encoder() = 0;
-  virtual void m_instantiate_decoder() = 0;
+  // Derived classes instantiate the correct encoder and decoder depending on 3D/2D/1D classes,
+  // and on the integer length in use. An existing instance of the correct type is kept.
+  virtual void m_instantiate_encoder(speck_int_ptr&) = 0;
+  virtual void m_instantiate_decoder(speck_int_ptr&) = 0;
+
+  // Code block mode: the {start, length} of every block in the coefficient volume, and
+  //    encoding/decoding of all blocks from/to `m_vals_ui` and `m_sign_array`.
+  auto m_code_block_extents() const -> std::vector<std::array<dims_type, 2>>;
+  auto m_encode_code_blocks() -> RTNType;
+  void m_decode_code_blocks();
+  auto m_code_blocks_len() const -> size_t;  // Total length of the stream of all blocks.
 
-  // Both wavelet transforms operate on `m_vals_d`.
+  // Both wavelet transforms operate on `m_vals_d`, after it's been handed over to `m_cdf`.
   virtual void m_wavelet_xform() = 0;
   virtual void m_inverse_wavelet_xform(bool multi_res) = 0;
 
@@ -120,6 +165,15 @@ class SPECK_FLT {
   //    - Rate: `param` must be the biggest magnitude of transformed wavelet coefficients;
   //            `high_prec` should be false at first, and true if not enough bits are produced.
   auto m_estimate_q(double param, bool high_prec) const -> double;
+
+  // PSNR mode only: starting from `q`, decrease it in steps of 2^(1/4) until the estimated MSE
+  //    of quantizing the wavelet coefficients is no bigger than `t_mse`.
+  auto m_estimate_q_psnr(double q, double t_mse) const -> double;
+
+  // Fixed-rate mode only: predict the size (in bits) of a complete SPECK encoding of the
+  //    quantized coefficients, so that a budget exceeding it goes to high precision right away
+  //    instead of after a wasted encoding. It needs `m_vals_ui` to hold uint32_t integers.
+  auto m_predict_lossless_bits() const -> size_t;
 };
 
 };  // namespace sperr
@@ -70,6 +70,7 @@ class SPECK_INT {
   virtual void m_sorting_pass() = 0;
   virtual void m_initialize_lists() = 0;
   void m_refinement_pass_encode();
+  template <bool Partial>  // Is the bitstream truncated?
   void m_refinement_pass_decode();
 
   // Data members
@@ -27,21 +27,46 @@ class SPERR3D_OMP_C {
   void set_direct_q(double);
 #endif
 
+  // Encode every chunk in independent code blocks (off by default). See
+  //    `SPECK_FLT::set_code_blocks()`; when the volume is a single chunk, all threads work on
+  //    its blocks.
+  void set_code_blocks(bool);
+
   // Apply compression on a volume pointed to by `buf`.
   template <typename T>
   auto compress(const T* buf, size_t buf_len) -> RTNType;
 
+  // Same as above, but the volume doesn't need to be contiguous: value (x, y, z) of the volume
+  //    is read from `base[offset + x * strides[0] + y * strides[1] + z * strides[2]]`, with the
+  //    offset and strides counted in elements of `T`. It allows compressing, e.g., the interior
+  //    of an array with ghost cells, or one field of an array of structs, without packing it
+  //    first. Every chunk is gathered from `base` by the thread that compresses it.
+  //    Strides must be non-zero.
+  template <typename T>
+  auto compress(const T* base, std::array<size_t, 3> strides, size_t offset = 0) -> RTNType;
+
   // Output: produce a vector containing the encoded bitstream.
   auto get_encoded_bitstream() const -> vec8_type;
 
+  // Record the wall time spent in, and bytes produced by, every stage of every chunk (off by
+  //    default). After `compress()`, the records are available for every chunk, and summed up
+  //    for every thread (indexed by OpenMP thread numbers) that processed chunks.
+  void enable_timing(bool);
+  auto view_chunk_timing() const -> const std::vector<StageTimes>&;
+  auto view_thread_timing() const -> const std::vector<StageTimes>&;
+
  private:
   bool m_orig_is_float = true;  // The original input precision is saved in header.
   CompMode m_mode = CompMode::Unknown;
   double m_quality = 0.0;
+  bool m_code_blocks = false;
   dims_type m_dims = {0, 0, 0};        // Dimension of the entire volume
   dims_type m_chunk_dims = {0, 0, 0};  // Preferred dimensions for a chunk
   std::vector<vec8_type> m_encoded_streams;
 
+  bool m_timing = false;
+  std::vector<StageTimes> m_chunk_times, m_thread_times;
+
 #ifdef USE_OMP
   size_t m_num_threads = 1;
 
@@ -65,11 +90,16 @@ class SPERR3D_OMP_C {
   //
   auto m_generate_header() const -> vec8_type;
 
-  // Gather a chunk from a bigger volume.
+  // Gather a chunk from a bigger volume, whose axes are `strides` elements apart, into
+  //    `chunk_buf`, reusing its memory.
   // If the requested chunk lives outside of the volume, whole or part,
-  //    this function returns an empty vector.
+  //    `chunk_buf` is left empty.
   template <typename T>
-  auto m_gather_chunk(const T* vol, dims_type vol_dim, std::array<size_t, 6> chunk) -> vecd_type;
+  void m_gather_chunk(const T* vol,
+                      dims_type vol_dim,
+                      std::array<size_t, 3> strides,
+                      std::array<size_t, 6> chunk,
+                      vecd_type& chunk_buf);
 };
 
 }  // End of namespace sperr
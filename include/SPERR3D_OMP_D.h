@@ -23,6 +23,25 @@ class SPERR3D_OMP_D {
   // The pointer passed in here MUST be the same as the one passed to `use_bitstream()`.
   auto decompress(const void* bitstream, bool multi_res = false) -> RTNType;
 
+  // Same as above, but the volume is decompressed straight into `dst`, a caller-supplied buffer
+  //    of `get_dims()` values in either float or double, instead of an internal double volume.
+  //    Every decoded chunk is converted to type `T` as it's put into `dst`, so no full volume in
+  //    double precision is ever allocated. `view_decoded_data()` is empty afterwards.
+  //    The hierarchy of multi-resolution decoding is still kept in double precision.
+  template <typename T>
+  auto decompress(const void* bitstream, T* dst, bool multi_res = false) -> RTNType;
+
+  // Same as above, but `dst` doesn't need to be contiguous: value (x, y, z) of the volume goes
+  //    to `dst[x * dst_strides[0] + y * dst_strides[1] + z * dst_strides[2]]`, with strides
+  //    counted in elements of `T`. It allows decompressing into, e.g., a sub-block of a bigger
+  //    array, or one field of an array of structs. Strides must be non-zero, and it's up to the
+  //    caller to make sure that different values don't land on the same element.
+  template <typename T>
+  auto decompress(const void* bitstream,
+                  T* dst,
+                  std::array<size_t, 3> dst_strides,
+                  bool multi_res = false) -> RTNType;
+
   auto view_decoded_data() const -> const sperr::vecd_type&;
   auto view_hierarchy() const -> const std::vector<vecd_type>&;
   auto release_decoded_data() -> sperr::vecd_type&&;
@@ -31,10 +50,20 @@ class SPERR3D_OMP_D {
   auto get_dims() const -> sperr::dims_type;
   auto get_chunk_dims() const -> sperr::dims_type;
 
+  // Record the wall time spent in, and bytes produced by, every stage of every chunk (off by
+  //    default). After `decompress()`, the records are available for every chunk, and summed up
+  //    for every thread (indexed by OpenMP thread numbers) that processed chunks.
+  void enable_timing(bool);
+  auto view_chunk_timing() const -> const std::vector<StageTimes>&;
+  auto view_thread_timing() const -> const std::vector<StageTimes>&;
+
  private:
   sperr::dims_type m_dims = {0, 0, 0};        // Dimension of the entire volume
   sperr::dims_type m_chunk_dims = {0, 0, 0};  // Preferred dimensions for a chunk
 
+  bool m_timing = false;
+  std::vector<StageTimes> m_chunk_times, m_thread_times;
+
 #ifdef USE_OMP
   size_t m_num_threads = 1;
 
@@ -59,10 +88,18 @@ class SPERR3D_OMP_D {
   const size_t m_header_magic_nchunks = 20;
   const size_t m_header_magic_1chunk = 14;
 
-  // Put this chunk to a bigger volume
+  // Decompress all chunks into `dst`, which holds the entire volume with strides `dst_strides`.
+  template <typename T>
+  auto m_decompress(const void* bitstream,
+                    T* dst,
+                    std::array<size_t, 3> dst_strides,
+                    bool multi_res) -> RTNType;
+
+  // Put this chunk to a bigger volume, whose axes are `strides` elements apart.
   // Memory errors will occur if the big and small volumes are not the same size as described.
-  void m_scatter_chunk(vecd_type& big_vol,
-                       dims_type vol_dim,
+  template <typename T>
+  void m_scatter_chunk(T* big_vol,
+                       std::array<size_t, 3> strides,
                        const vecd_type& small_vol,
                        std::array<size_t, 6> chunk_info);
 };
@@ -41,6 +41,10 @@ enum class SigType : unsigned char { Insig, Sig, Dunno, Garbage };
 
 enum class UINTType : unsigned char { UINT8, UINT16, UINT32, UINT64 };
 
+// Instruction sets that SIMD kernels are written for. They are listed from the least
+// to the most capable, and `Scalar` is always available.
+enum class ISAType : unsigned char { Scalar, AVX2, AVX512 };
+
 enum class CompMode : unsigned char {
   PSNR,
   PWE,
@@ -63,9 +67,39 @@ enum class RTNType {
   Error
 };
 
+// Stages of compression and decompression, whose costs are recorded in `StageTimes`.
+enum class StageType : unsigned char { Condition, Xform, Quantize, Outlier, Speck, Count };
+
+// Wall time (in seconds) spent in, and bytes produced by, every stage of a compression or a
+//    decompression, indexed by `StageType`. A stage that runs multiple times (e.g., wavelet
+//    transforms in PWE mode) accumulates all of its runs.
+struct StageTimes {
+  std::array<double, size_t(StageType::Count)> seconds = {};
+  std::array<size_t, size_t(StageType::Count)> bytes = {};
+
+  // Fixed-rate mode only: how many times high quantization precision was chosen up front by
+  //    predicting the encoded size, and how many times an encoding had to be redone instead.
+  size_t rate_predicted = 0;
+  size_t rate_retried = 0;
+
+  void record(StageType, double sec, size_t num_bytes);
+  auto total_seconds() const -> double;
+  auto operator+=(const StageTimes&) -> StageTimes&;
+};
+
 //
 // Helper functions
 //
+// Tell if an instruction set is supported by both this build (option USE_SIMD) and the CPU
+//    that's running this program. `ISAType::Scalar` is always supported.
+auto isa_supported(ISAType) -> bool;
+
+// Return the most capable instruction set supported by both this build and the running CPU.
+auto best_isa() -> ISAType;
+
+// A short name of a stage, e.g., for printing a `StageTimes`.
+auto stage_name(StageType) -> const char*;
+
 // Given a certain length, how many transforms to be performed?
 auto num_of_xforms(size_t len) -> size_t;
 
@@ -81,6 +81,29 @@ auto sperr::Bitstream::rbit() -> bool
   return bit;
 }
 
+auto sperr::Bitstream::rbits(size_t nbits) -> uint64_t
+{
+  assert(nbits <= 64);
+  if (nbits <= m_bits) {
+    const auto mask = (uint64_t{1} << nbits) - 1;  // m_bits is always less than 64.
+    const auto bits = m_buffer & mask;
+    m_buffer >>= nbits;
+    m_bits -= nbits;
+    return bits;
+  }
+
+  // Take all the buffered bits, and the rest from the next word.
+  const auto word = *m_itr;
+  ++m_itr;
+  const auto need = nbits - m_bits;
+  auto bits = m_buffer | (word << m_bits);
+  if (nbits < 64)
+    bits &= (uint64_t{1} << nbits) - 1;
+  m_buffer = need < 64 ? word >> need : 0;
+  m_bits = 64 - need;
+  return bits;
+}
+
 // Functions for write
 auto sperr::Bitstream::wtell() const -> size_t
 {
@@ -127,6 +150,31 @@ void sperr::Bitstream::wbit(bool bit)
   }
 }
 
+void sperr::Bitstream::wbits(uint64_t bits, size_t nbits)
+{
+  assert(nbits <= 64);
+  assert(nbits == 64 || bits >> nbits == 0);
+
+  m_buffer |= bits << m_bits;  // m_bits is always less than 64.
+  if (m_bits + nbits < 64) {
+    m_bits += nbits;
+    return;
+  }
+
+  if (m_itr == m_buf.end()) {  // allocate memory if necessary.
+    auto dist = m_buf.size();
+    m_buf.resize(std::max(size_t{1}, dist) * 2 - dist / 2);  // use a growth factor of 1.5
+    m_itr = m_buf.begin() + dist;
+  }
+  *m_itr = m_buffer;
+  ++m_itr;
+
+  // Keep the bits that didn't fit in the word just written.
+  const auto remain = m_bits + nbits - 64;
+  m_buffer = remain ? bits >> (nbits - remain) : 0;
+  m_bits = remain;
+}
+
 void sperr::Bitstream::flush()
 {
   if (m_bits) {  // only really flush when there are remaining bits.
@@ -1,150 +1,368 @@
 #include "CDF97.h"
+#include "CDF97_Kernels.h"
 
 #include <algorithm>
 #include <cassert>
 #include <numeric>  // std::accumulate()
 #include <type_traits>
 
+#ifdef USE_OMP
+#include <omp.h>
+#endif
+
+namespace {
+
+// Index of the calling thread within the current team, which picks its scratch buffers.
+inline auto thread_id() -> size_t
+{
+#ifdef USE_OMP
+  return omp_get_thread_num();
+#else
+  return 0;
+#endif
+}
+
+// Ranges of a signal of length `sig_len` that are involved in reconstructing its range
+//    [start, start + len) after `num_xforms` levels of transform. The i-th element is the range,
+//    as {start, length}, of the approximation at level i that is inverse transformed to produce
+//    the range needed at level i - 1 (or the requested range, for i == 0). Every range is padded
+//    by the radius of the synthesis lifting steps, and starts at an even index so that its low
+//    and high pass coefficients are contiguous ranges of the coarser level.
+auto region_ranges(size_t sig_len, size_t start, size_t len, size_t num_xforms)
+    -> std::vector<std::array<size_t, 2>>
+{
+  const size_t radius = 4;
+  auto ranges = std::vector<std::array<size_t, 2>>(num_xforms);
+  for (size_t lev = 0; lev < num_xforms; lev++) {
+    const auto approx_len = sperr::calc_approx_detail_len(sig_len, lev)[0];
+    const auto beg = start > radius ? (start - radius) / 2 * 2 : 0;
+    const auto end = std::min(start + len + radius, approx_len);
+    ranges[lev] = {beg, end - beg};
+    start = beg / 2;
+    len = end - beg - (end - beg) / 2;
+  }
+  return ranges;
+}
+
+}  // anonymous namespace
+
+auto sperr::make_dwt_plan(dims_type dims) -> std::shared_ptr<const DWT_Plan>
+{
+  auto plan = std::make_shared<DWT_Plan>();
+  plan->dims = dims;
+
+  // A dimension without values (e.g., before any data is passed in) needs no transforms.
+  if (std::any_of(dims.cbegin(), dims.cend(), [](auto d) { return d == 0; })) {
+    plan->approx.assign(1, dims);
+    return plan;
+  }
+
+  plan->dyadic = sperr::can_use_dyadic(dims);
+  plan->xforms_x = sperr::num_of_xforms(dims[0]);
+  plan->xforms_xy = sperr::num_of_xforms(std::min(dims[0], dims[1]));
+  plan->xforms_z = sperr::num_of_xforms(dims[2]);
+  plan->max_col = *std::max_element(dims.cbegin(), dims.cend());
+
+  const auto max_lev = std::max({plan->dyadic.value_or(0), plan->xforms_x, plan->xforms_xy,
+                                 plan->xforms_z});
+  plan->approx.resize(max_lev + 1);
+  for (size_t lev = 0; lev <= max_lev; lev++) {
+    for (size_t i = 0; i < 3; i++)
+      plan->approx[lev][i] = sperr::calc_approx_detail_len(dims[i], lev)[0];
+  }
+
+  return plan;
+}
+
+auto sperr::make_dwt_plans(const std::vector<std::array<size_t, 6>>& chunks)
+    -> std::vector<std::shared_ptr<const DWT_Plan>>
+{
+  auto plans = std::vector<std::shared_ptr<const DWT_Plan>>();
+  for (const auto& chunk : chunks) {
+    const auto dims = dims_type{chunk[1], chunk[3], chunk[5]};
+    if (std::none_of(plans.cbegin(), plans.cend(), [dims](auto& p) { return p->dims == dims; }))
+      plans.emplace_back(sperr::make_dwt_plan(dims));
+  }
+  return plans;
+}
+
 template <typename T>
-auto sperr::CDF97::copy_data(const T* data, size_t len, dims_type dims) -> RTNType
+template <typename U>
+auto sperr::CDF97<T>::copy_data(const U* data, size_t len, dims_type dims) -> RTNType
 {
-  static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
+  static_assert(std::is_floating_point<U>::value, "!! Only floating point values are supported !!");
   if (len != dims[0] * dims[1] * dims[2])
     return RTNType::WrongLength;
 
   m_data_buf.resize(len);
   std::copy(data, data + len, m_data_buf.begin());
 
-  m_dims = dims;
-
-  auto max_col = std::max(std::max(dims[0], dims[1]), dims[2]);
-  if (max_col * 2 > m_qcc_buf.size())
-    m_qcc_buf.resize(std::max(m_qcc_buf.size(), max_col) * 2);
-
-  auto max_slice = std::max(std::max(dims[0] * dims[1], dims[0] * dims[2]), dims[1] * dims[2]);
-  if (max_slice > m_slice_buf.size())
-    m_slice_buf.resize(std::max(m_slice_buf.size() * 2, max_slice));
+  m_set_dims(dims);
 
   return RTNType::Good;
 }
-template auto sperr::CDF97::copy_data(const float*, size_t, dims_type) -> RTNType;
-template auto sperr::CDF97::copy_data(const double*, size_t, dims_type) -> RTNType;
-
-auto sperr::CDF97::take_data(vecd_type&& buf, dims_type dims) -> RTNType
+template <typename T>
+auto sperr::CDF97<T>::take_data(vec_type<T>&& buf, dims_type dims) -> RTNType
 {
   if (buf.size() != dims[0] * dims[1] * dims[2])
     return RTNType::WrongLength;
 
   m_data_buf = std::move(buf);
-  m_dims = dims;
-
-  auto max_col = std::max(std::max(dims[0], dims[1]), dims[2]);
-  if (max_col * 2 > m_qcc_buf.size())
-    m_qcc_buf.resize(std::max(m_qcc_buf.size(), max_col) * 2);
-
-  auto max_slice = std::max(std::max(dims[0] * dims[1], dims[0] * dims[2]), dims[1] * dims[2]);
-  if (max_slice > m_slice_buf.size())
-    m_slice_buf.resize(std::max(m_slice_buf.size() * 2, max_slice));
+  m_set_dims(dims);
 
   return RTNType::Good;
 }
 
-auto sperr::CDF97::view_data() const -> const vecd_type&
+template <typename T>
+auto sperr::CDF97<T>::view_data() const -> const vec_type<T>&
 {
   return m_data_buf;
 }
 
-auto sperr::CDF97::release_data() -> vecd_type&&
+template <typename T>
+auto sperr::CDF97<T>::release_data() -> vec_type<T>&&
 {
   return std::move(m_data_buf);
 }
 
-auto sperr::CDF97::get_dims() const -> std::array<size_t, 3>
+template <typename T>
+auto sperr::CDF97<T>::set_isa(ISAType isa) -> RTNType
+{
+  if (!sperr::isa_supported(isa))
+    return RTNType::Error;
+
+  m_isa = isa;
+  return RTNType::Good;
+}
+
+template <typename T>
+auto sperr::CDF97<T>::get_isa() const -> ISAType
+{
+  return m_isa;
+}
+
+template <typename T>
+void sperr::CDF97<T>::set_z_tile(std::array<size_t, 2> tile)
+{
+  m_z_tile[0] = std::max(tile[0], size_t{1});
+  m_z_tile[1] = std::max(tile[1], size_t{1});
+}
+
+template <typename T>
+auto sperr::CDF97<T>::get_z_tile() const -> std::array<size_t, 2>
+{
+  return m_z_tile;
+}
+
+template <typename T>
+void sperr::CDF97<T>::set_num_threads([[maybe_unused]] size_t n)
+{
+#ifdef USE_OMP
+  if (n == 0)
+    m_num_threads = omp_get_max_threads();
+  else
+    m_num_threads = n;
+  m_alloc_scratch();
+#endif
+}
+
+template <typename T>
+auto sperr::CDF97<T>::get_num_threads() const -> size_t
+{
+  return m_num_threads;
+}
+
+template <typename T>
+void sperr::CDF97<T>::use_plan(std::shared_ptr<const DWT_Plan> plan)
+{
+  if (plan == nullptr)
+    return;
+
+  auto same = std::find_if(m_plans.begin(), m_plans.end(),
+                           [&plan](const auto& p) { return p->dims == plan->dims; });
+  if (same != m_plans.end())
+    *same = std::move(plan);
+  else {
+    if (m_plans.size() == MAX_PLANS)
+      m_plans.erase(m_plans.begin());
+    m_plans.emplace_back(std::move(plan));
+  }
+}
+
+template <typename T>
+void sperr::CDF97<T>::m_set_dims(dims_type dims)
+{
+  m_dims = dims;
+  if (m_plan->dims != dims) {
+    auto same = std::find_if(m_plans.cbegin(), m_plans.cend(),
+                             [dims](const auto& p) { return p->dims == dims; });
+    if (same == m_plans.cend()) {
+      use_plan(sperr::make_dwt_plan(dims));
+      same = std::prev(m_plans.cend());
+    }
+    m_plan = *same;
+  }
+  m_alloc_scratch();
+}
+
+template <typename T>
+void sperr::CDF97<T>::m_alloc_scratch()
+{
+  m_qcc_buf.resize(m_num_threads);
+  m_lane_buf.resize(m_num_threads);
+
+  const auto max_col = m_plan->max_col;
+  for (auto& buf : m_qcc_buf) {
+    if (max_col * 2 > buf.size())
+      buf.resize(max_col * 2);
+  }
+  for (auto& buf : m_lane_buf) {
+    if (max_col * LANES > buf.size())
+      buf.resize(max_col * LANES);
+  }
+}
+
+template <typename T>
+auto sperr::CDF97<T>::get_dims() const -> std::array<size_t, 3>
 {
   return m_dims;
 }
 
-void sperr::CDF97::dwt1d()
+template <typename T>
+void sperr::CDF97<T>::dwt1d()
 {
-  auto num_xforms = sperr::num_of_xforms(m_dims[0]);
-  m_dwt1d(m_data_buf.begin(), m_data_buf.size(), num_xforms);
+  m_dwt1d(m_data_buf.begin(), m_data_buf.size(), m_plan->xforms_x);
 }
 
-void sperr::CDF97::idwt1d()
+template <typename T>
+void sperr::CDF97<T>::idwt1d()
 {
-  auto num_xforms = sperr::num_of_xforms(m_dims[0]);
-  m_idwt1d(m_data_buf.begin(), m_data_buf.size(), num_xforms);
+  m_idwt1d(m_data_buf.begin(), m_data_buf.size(), m_plan->xforms_x);
 }
 
-void sperr::CDF97::dwt2d()
+template <typename T>
+void sperr::CDF97<T>::dwt2d()
 {
-  auto xy = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
-  m_dwt2d(m_data_buf.begin(), {m_dims[0], m_dims[1]}, xy);
+  m_dwt2d(m_data_buf.begin(), {m_dims[0], m_dims[1]}, m_plan->xforms_xy);
 }
 
-void sperr::CDF97::idwt2d()
+template <typename T>
+void sperr::CDF97<T>::idwt2d()
 {
-  auto xy = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
-  m_idwt2d(m_data_buf.begin(), {m_dims[0], m_dims[1]}, xy);
+  m_idwt2d(m_data_buf.begin(), {m_dims[0], m_dims[1]}, m_plan->xforms_xy);
 }
 
-auto sperr::CDF97::idwt2d_multi_res() -> std::vector<vecd_type>
+template <typename T>
+auto sperr::CDF97<T>::idwt2d_multi_res() -> std::vector<vecd_type>
 {
-  const auto xy = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
+  const auto xy = m_plan->xforms_xy;
   auto ret = std::vector<vecd_type>();
 
   if (xy > 0) {
     ret.reserve(xy);
     for (size_t lev = xy; lev > 0; lev--) {
-      auto [x, xd] = sperr::calc_approx_detail_len(m_dims[0], lev);
-      auto [y, yd] = sperr::calc_approx_detail_len(m_dims[1], lev);
-      ret.emplace_back(m_sub_slice({x, y}));
-      m_idwt2d_one_level(m_data_buf.begin(), {x + xd, y + yd});
+      const auto& approx = m_plan->approx[lev];
+      const auto& finer = m_plan->approx[lev - 1];
+      ret.emplace_back(m_sub_slice({approx[0], approx[1]}));
+      m_idwt2d_one_level(m_data_buf.begin(), {finer[0], finer[1]});
     }
   }
 
   return ret;
 }
 
-void sperr::CDF97::dwt3d()
+template <typename T>
+void sperr::CDF97<T>::dwt3d()
 {
-  auto dyadic = sperr::can_use_dyadic(m_dims);
+  const auto dyadic = m_plan->dyadic;
   if (dyadic)
     m_dwt3d_dyadic(*dyadic);
   else
     m_dwt3d_wavelet_packet();
 }
 
-void sperr::CDF97::idwt3d()
+template <typename T>
+void sperr::CDF97<T>::idwt3d()
 {
-  auto dyadic = sperr::can_use_dyadic(m_dims);
+  const auto dyadic = m_plan->dyadic;
   if (dyadic)
     m_idwt3d_dyadic(*dyadic);
   else
     m_idwt3d_wavelet_packet();
 }
 
-void sperr::CDF97::idwt3d_multi_res(std::vector<vecd_type>& h)
+template <typename T>
+void sperr::CDF97<T>::idwt3d_multi_res(std::vector<vecd_type>& h)
 {
-  auto dyadic = sperr::can_use_dyadic(m_dims);
+  const auto dyadic = m_plan->dyadic;
 
   if (dyadic) {
     h.resize(*dyadic);
     for (size_t lev = *dyadic; lev > 0; lev--) {
-      auto [x, xd] = sperr::calc_approx_detail_len(m_dims[0], lev);
-      auto [y, yd] = sperr::calc_approx_detail_len(m_dims[1], lev);
-      auto [z, zd] = sperr::calc_approx_detail_len(m_dims[2], lev);
+      const auto& approx = m_plan->approx[lev];
       auto& buf = h[*dyadic - lev];
-      buf.resize(x * y * z);
-      m_sub_volume({x, y, z}, buf.begin());
-      m_idwt3d_one_level(m_data_buf.begin(), {x + xd, y + yd, z + zd});
+      buf.resize(approx[0] * approx[1] * approx[2]);
+      m_sub_volume(approx, buf.begin());
+      m_idwt3d_one_level(m_data_buf.begin(), m_plan->approx[lev - 1]);
     }
   }
   else
     m_idwt3d_wavelet_packet();
 }
 
-void sperr::CDF97::m_dwt3d_wavelet_packet()
+template <typename T>
+auto sperr::CDF97<T>::idwt3d_region(std::array<size_t, 6> box) const -> vec_type<T>
+{
+  for (size_t i = 0; i < 3; i++) {
+    if (box[i * 2 + 1] == 0 || box[i * 2] + box[i * 2 + 1] > m_dims[i])
+      return {};
+  }
+  if (m_data_buf.size() != m_dims[0] * m_dims[1] * m_dims[2])
+    return {};
+
+  const auto dyadic = m_plan->dyadic;
+  if (dyadic)
+    return m_idwt_region(m_data_buf.data(), m_dims, box, {true, true, true}, *dyadic);
+
+  // Wavelet packet: XY planes are inverse transformed before the Z columns, so first find out
+  //    the planes that the Z columns within the box need, i.e., the coarsest low pass range and
+  //    the high pass range of every level.
+  const auto num_xforms_z = m_plan->xforms_z;
+  auto planes = std::vector<bool>(m_dims[2], false);
+  if (num_xforms_z == 0)
+    std::fill(planes.begin() + box[4], planes.begin() + box[4] + box[5], true);
+  const auto ranges = region_ranges(m_dims[2], box[4], box[5], num_xforms_z);
+  for (size_t lev = 0; lev < num_xforms_z; lev++) {
+    const auto [beg, len] = ranges[lev];
+    const auto approx_len = m_plan->approx[lev][2];
+    const auto high = planes.begin() + approx_len - approx_len / 2 + beg / 2;
+    std::fill(high, high + len / 2, true);
+    if (lev == num_xforms_z - 1)
+      std::fill(planes.begin() + beg / 2, planes.begin() + beg / 2 + len - len / 2, true);
+  }
+
+  // Reconstruct the XY extent of the box on each of these planes...
+  const auto num_xforms_xy = m_plan->xforms_xy;
+  const auto plane_size_xy = m_dims[0] * m_dims[1];
+  const auto box_size_xy = box[1] * box[3];
+  auto tmp = vec_type<T>(box_size_xy * m_dims[2]);
+  for (size_t z = 0; z < m_dims[2]; z++) {
+    if (planes[z]) {
+      const auto rect = m_idwt_region(m_data_buf.data() + z * plane_size_xy,
+                                      {m_dims[0], m_dims[1], 1},
+                                      {box[0], box[1], box[2], box[3], 0, 1}, {true, true, false},
+                                      num_xforms_xy);
+      std::copy(rect.begin(), rect.end(), tmp.begin() + z * box_size_xy);
+    }
+  }
+
+  // ... and then the Z extent of the box on the resulting columns.
+  return m_idwt_region(tmp.data(), {box[1], box[3], m_dims[2]},
+                       {0, box[1], 0, box[3], box[4], box[5]}, {false, false, true}, num_xforms_z);
+}
+
+template <typename T>
+void sperr::CDF97<T>::m_dwt3d_wavelet_packet()
 {
   /*
    *             Z
@@ -165,52 +383,28 @@ void sperr::CDF97::m_dwt3d_wavelet_packet()
 
   const size_t plane_size_xy = m_dims[0] * m_dims[1];
 
-  // First transform along the Z dimension
+  // First transform along the Z dimension, one tile of Z columns at a time
   //
-  const auto num_xforms_z = sperr::num_of_xforms(m_dims[2]);
-
-  for (size_t y = 0; y < m_dims[1]; y++) {
-    const auto y_offset = y * m_dims[0];
-
-    // Re-arrange values of one XZ slice so that they form many z_columns
-    for (size_t z = 0; z < m_dims[2]; z++) {
-      const auto cube_start_idx = z * plane_size_xy + y_offset;
-      for (size_t x = 0; x < m_dims[0]; x++)
-        m_slice_buf[z + x * m_dims[2]] = m_data_buf[cube_start_idx + x];
-    }
-
-    // DWT1D on every z_column
-    for (size_t x = 0; x < m_dims[0]; x++)
-      m_dwt1d(m_slice_buf.begin() + x * m_dims[2], m_dims[2], num_xforms_z);
-
-    // Put back values of the z_columns to the cube
-    for (size_t z = 0; z < m_dims[2]; z++) {
-      const auto cube_start_idx = z * plane_size_xy + y_offset;
-      for (size_t x = 0; x < m_dims[0]; x++)
-        m_data_buf[cube_start_idx + x] = m_slice_buf[z + x * m_dims[2]];
-    }
-  }
+  m_dwt_z(m_data_buf.begin(), m_dims, m_plan->xforms_z);
 
   // Second transform each plane
   //
-  const auto num_xforms_xy = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
-
   for (size_t z = 0; z < m_dims[2]; z++) {
     const size_t offset = plane_size_xy * z;
-    m_dwt2d(m_data_buf.begin() + offset, {m_dims[0], m_dims[1]}, num_xforms_xy);
+    m_dwt2d(m_data_buf.begin() + offset, {m_dims[0], m_dims[1]}, m_plan->xforms_xy);
   }
 }
 
-void sperr::CDF97::m_idwt3d_wavelet_packet()
+template <typename T>
+void sperr::CDF97<T>::m_idwt3d_wavelet_packet()
 {
   const size_t plane_size_xy = m_dims[0] * m_dims[1];
 
   // First, inverse transform each plane
   //
-  auto num_xforms_xy = sperr::num_of_xforms(std::min(m_dims[0], m_dims[1]));
   for (size_t i = 0; i < m_dims[2]; i++) {
     const size_t offset = plane_size_xy * i;
-    m_idwt2d(m_data_buf.begin() + offset, {m_dims[0], m_dims[1]}, num_xforms_xy);
+    m_idwt2d(m_data_buf.begin() + offset, {m_dims[0], m_dims[1]}, m_plan->xforms_xy);
   }
 
   /*
@@ -232,56 +426,30 @@ void sperr::CDF97::m_idwt3d_wavelet_packet()
    *       Y
    */
 
-  // Process one XZ slice at a time
+  // Process one tile of Z columns at a time
   //
-  const auto num_xforms_z = sperr::num_of_xforms(m_dims[2]);
-  for (size_t y = 0; y < m_dims[1]; y++) {
-    const auto y_offset = y * m_dims[0];
-
-    // Re-arrange values on one slice so that they form many z_columns
-    for (size_t z = 0; z < m_dims[2]; z++) {
-      const auto cube_start_idx = z * plane_size_xy + y_offset;
-      for (size_t x = 0; x < m_dims[0]; x++)
-        m_slice_buf[z + x * m_dims[2]] = m_data_buf[cube_start_idx + x];
-    }
-
-    // IDWT1D on every z_column
-    for (size_t x = 0; x < m_dims[0]; x++)
-      m_idwt1d(m_slice_buf.begin() + x * m_dims[2], m_dims[2], num_xforms_z);
-
-    // Put back values from the z_columns to the cube
-    for (size_t z = 0; z < m_dims[2]; z++) {
-      const auto cube_start_idx = z * plane_size_xy + y_offset;
-      for (size_t x = 0; x < m_dims[0]; x++)
-        m_data_buf[cube_start_idx + x] = m_slice_buf[z + x * m_dims[2]];
-    }
-  }
+  m_idwt_z(m_data_buf.begin(), m_dims, m_plan->xforms_z);
 }
 
-void sperr::CDF97::m_dwt3d_dyadic(size_t num_xforms)
+template <typename T>
+void sperr::CDF97<T>::m_dwt3d_dyadic(size_t num_xforms)
 {
-  for (size_t lev = 0; lev < num_xforms; lev++) {
-    auto [x, xd] = sperr::calc_approx_detail_len(m_dims[0], lev);
-    auto [y, yd] = sperr::calc_approx_detail_len(m_dims[1], lev);
-    auto [z, zd] = sperr::calc_approx_detail_len(m_dims[2], lev);
-    m_dwt3d_one_level(m_data_buf.begin(), {x, y, z});
-  }
+  for (size_t lev = 0; lev < num_xforms; lev++)
+    m_dwt3d_one_level(m_data_buf.begin(), m_plan->approx[lev]);
 }
 
-void sperr::CDF97::m_idwt3d_dyadic(size_t num_xforms)
+template <typename T>
+void sperr::CDF97<T>::m_idwt3d_dyadic(size_t num_xforms)
 {
-  for (size_t lev = num_xforms; lev > 0; lev--) {
-    auto [x, xd] = sperr::calc_approx_detail_len(m_dims[0], lev - 1);
-    auto [y, yd] = sperr::calc_approx_detail_len(m_dims[1], lev - 1);
-    auto [z, zd] = sperr::calc_approx_detail_len(m_dims[2], lev - 1);
-    m_idwt3d_one_level(m_data_buf.begin(), {x, y, z});
-  }
+  for (size_t lev = num_xforms; lev > 0; lev--)
+    m_idwt3d_one_level(m_data_buf.begin(), m_plan->approx[lev - 1]);
 }
 
 //
 // Private Methods
 //
-void sperr::CDF97::m_dwt1d(itd_type array, size_t array_len, size_t num_of_lev)
+template <typename T>
+void sperr::CDF97<T>::m_dwt1d(itd_type array, size_t array_len, size_t num_of_lev)
 {
   for (size_t lev = 0; lev < num_of_lev; lev++) {
     auto [x, xd] = sperr::calc_approx_detail_len(array_len, lev);
@@ -289,7 +457,8 @@ void sperr::CDF97::m_dwt1d(itd_type array, size_t array_len, size_t num_of_lev)
   }
 }
 
-void sperr::CDF97::m_idwt1d(itd_type array, size_t array_len, size_t num_of_lev)
+template <typename T>
+void sperr::CDF97<T>::m_idwt1d(itd_type array, size_t array_len, size_t num_of_lev)
 {
   for (size_t lev = num_of_lev; lev > 0; lev--) {
     auto [x, xd] = sperr::calc_approx_detail_len(array_len, lev - 1);
@@ -297,7 +466,8 @@ void sperr::CDF97::m_idwt1d(itd_type array, size_t array_len, size_t num_of_lev)
   }
 }
 
-void sperr::CDF97::m_dwt2d(itd_type plane, std::array<size_t, 2> len_xy, size_t num_of_lev)
+template <typename T>
+void sperr::CDF97<T>::m_dwt2d(itd_type plane, std::array<size_t, 2> len_xy, size_t num_of_lev)
 {
   for (size_t lev = 0; lev < num_of_lev; lev++) {
     auto [x, xd] = sperr::calc_approx_detail_len(len_xy[0], lev);
@@ -306,7 +476,8 @@ void sperr::CDF97::m_dwt2d(itd_type plane, std::array<size_t, 2> len_xy, size_t
   }
 }
 
-void sperr::CDF97::m_idwt2d(itd_type plane, std::array<size_t, 2> len_xy, size_t num_of_lev)
+template <typename T>
+void sperr::CDF97<T>::m_idwt2d(itd_type plane, std::array<size_t, 2> len_xy, size_t num_of_lev)
 {
   for (size_t lev = num_of_lev; lev > 0; lev--) {
     auto [x, xd] = sperr::calc_approx_detail_len(len_xy[0], lev - 1);
@@ -315,58 +486,50 @@ void sperr::CDF97::m_idwt2d(itd_type plane, std::array<size_t, 2> len_xy, size_t
   }
 }
 
-void sperr::CDF97::m_dwt1d_one_level(itd_type array, size_t array_len)
+template <typename T>
+void sperr::CDF97<T>::m_dwt1d_one_level(itd_type array, size_t array_len)
 {
-  std::copy(array, array + array_len, m_qcc_buf.begin());
-  if (array_len % 2 == 0) {
-    this->QccWAVCDF97AnalysisSymmetricEvenEven(m_qcc_buf.data(), array_len);
-    m_gather_even(m_qcc_buf.cbegin(), m_qcc_buf.cbegin() + array_len, array);
-  }
-  else {
-    this->QccWAVCDF97AnalysisSymmetricOddEven(m_qcc_buf.data(), array_len);
-    m_gather_odd(m_qcc_buf.cbegin(), m_qcc_buf.cbegin() + array_len, array);
-  }
+  // Low pass results are written in place, while high pass results go to a buffer first.
+  // Note: a single signal can't be split across threads, so only the first buffer is used.
+  const auto& k = sperr::lifting_kernels<T>(m_isa);
+  const auto coeffs = LiftingCoeffs<T>{ALPHA, BETA, GAMMA, DELTA, EPSILON, INV_EPSILON};
+  auto& buf = m_qcc_buf[0];
+  auto* const p = &*array;
+  k.analysis(p, 1, p, 1, buf.data(), 1, array_len, 1, coeffs);
+  std::copy(buf.cbegin(), buf.cbegin() + array_len / 2, p + array_len - array_len / 2);
 }
 
-void sperr::CDF97::m_idwt1d_one_level(itd_type array, size_t array_len)
+template <typename T>
+void sperr::CDF97<T>::m_idwt1d_one_level(itd_type array, size_t array_len)
 {
-  if (array_len % 2 == 0) {
-    m_scatter_even(array, array + array_len, m_qcc_buf.begin());
-    this->QccWAVCDF97SynthesisSymmetricEvenEven(m_qcc_buf.data(), array_len);
-  }
-  else {
-    m_scatter_odd(array, array + array_len, m_qcc_buf.begin());
-    this->QccWAVCDF97SynthesisSymmetricOddEven(m_qcc_buf.data(), array_len);
-  }
-  std::copy(m_qcc_buf.cbegin(), m_qcc_buf.cbegin() + array_len, array);
+  // Low pass coefficients are copied to a buffer first, so the results can be written in place.
+  const auto& k = sperr::lifting_kernels<T>(m_isa);
+  const auto coeffs = LiftingCoeffs<T>{ALPHA, BETA, GAMMA, DELTA, EPSILON, INV_EPSILON};
+  auto& buf = m_qcc_buf[0];
+  auto* const p = &*array;
+  const auto low_len = array_len - array_len / 2;
+  std::copy(p, p + low_len, buf.begin());
+  k.synthesis(buf.data(), 1, p + low_len, 1, p, 1, array_len, 1, coeffs);
 }
 
-void sperr::CDF97::m_dwt2d_one_level(itd_type plane, std::array<size_t, 2> len_xy)
+template <typename T>
+void sperr::CDF97<T>::m_dwt2d_one_level(itd_type plane, std::array<size_t, 2> len_xy)
 {
-  // Note: here we call low-level functions (Qcc*()) instead of
-  // m_dwt1d_one_level() because we want to have only one even/odd test at the outer loop.
-
-  const auto max_len = std::max(len_xy[0], len_xy[1]);
-  const auto beg = m_qcc_buf.begin();
-  const auto beg2 = beg + max_len;
+  // Note: rows (and batches of columns) are independent, so each thread works on its own
+  // subset of them using its own buffer.
+  const auto& k = sperr::lifting_kernels<T>(m_isa);
+  const auto coeffs = LiftingCoeffs<T>{ALPHA, BETA, GAMMA, DELTA, EPSILON, INV_EPSILON};
+  auto* const p = &*plane;
+  const auto stride = m_dims[0];
 
   // First, perform DWT along X for every row
-  if (len_xy[0] % 2 == 0) {
-    for (size_t i = 0; i < len_xy[1]; i++) {
-      auto pos = plane + i * m_dims[0];
-      std::copy(pos, pos + len_xy[0], beg);
-      this->QccWAVCDF97AnalysisSymmetricEvenEven(m_qcc_buf.data(), len_xy[0]);
-      m_gather_even(beg, beg + len_xy[0], pos);
-    }
-  }
-  else  // Odd length
-  {
-    for (size_t i = 0; i < len_xy[1]; i++) {
-      auto pos = plane + i * m_dims[0];
-      std::copy(pos, pos + len_xy[0], beg);
-      this->QccWAVCDF97AnalysisSymmetricOddEven(m_qcc_buf.data(), len_xy[0]);
-      m_gather_odd(beg, beg + len_xy[0], pos);
-    }
+  const auto low_x = len_xy[0] - len_xy[0] / 2;
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < len_xy[1]; i++) {
+    auto& buf = m_qcc_buf[thread_id()];
+    auto* const pos = p + i * stride;
+    k.analysis(pos, 1, pos, 1, buf.data(), 1, len_xy[0], 1, coeffs);
+    std::copy(buf.cbegin(), buf.cbegin() + len_xy[0] / 2, pos + low_x);
   }
 
   // Second, perform DWT along Y for every column
@@ -375,80 +538,64 @@ void sperr::CDF97::m_dwt2d_one_level(itd_type plane, std::array<size_t, 2> len_x
   // on both a MacBook and a RaspberryPi 3. Note2, I've tested transpose again
   // on an X86 linux machine using gcc, clang, and pgi. Again the difference is
   // either indistinguishable, or the current implementation has a slight edge.
-
-  if (len_xy[1] % 2 == 0) {
-    for (size_t x = 0; x < len_xy[0]; x++) {
-      for (size_t y = 0; y < len_xy[1]; y++)
-        m_qcc_buf[y] = *(plane + y * m_dims[0] + x);
-      this->QccWAVCDF97AnalysisSymmetricEvenEven(m_qcc_buf.data(), len_xy[1]);
-      m_gather_even(beg, beg + len_xy[1], beg2);
-      for (size_t y = 0; y < len_xy[1]; y++)
-        *(plane + y * m_dims[0] + x) = *(beg2 + y);
-    }
-  }
-  else  // Odd length
-  {
-    for (size_t x = 0; x < len_xy[0]; x++) {
-      for (size_t y = 0; y < len_xy[1]; y++)
-        m_qcc_buf[y] = *(plane + y * m_dims[0] + x);
-      this->QccWAVCDF97AnalysisSymmetricOddEven(m_qcc_buf.data(), len_xy[1]);
-      m_gather_odd(beg, beg + len_xy[1], beg2);
-      for (size_t y = 0; y < len_xy[1]; y++)
-        *(plane + y * m_dims[0] + x) = *(beg2 + y);
+  // Note3, columns are transformed in batches of `LANES`, so that every row segment
+  // read from (and written to) the plane feeds all columns of a batch. Low pass results
+  // are written in place, while high pass results go to a buffer first.
+  const auto low_y = len_xy[1] - len_xy[1] / 2;
+  const auto num_batches = (len_xy[0] + LANES - 1) / LANES;
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t batch = 0; batch < num_batches; batch++) {
+    auto& buf = m_lane_buf[thread_id()];
+    const auto x = batch * LANES;
+    const auto lanes = std::min(LANES, len_xy[0] - x);
+    auto* const col = p + x;
+    k.analysis(col, stride, col, stride, buf.data(), lanes, len_xy[1], lanes, coeffs);
+    for (size_t y = 0; y < len_xy[1] / 2; y++) {
+      auto src = buf.cbegin() + y * lanes;
+      std::copy(src, src + lanes, col + (low_y + y) * stride);
     }
   }
 }
 
-void sperr::CDF97::m_idwt2d_one_level(itd_type plane, std::array<size_t, 2> len_xy)
-{
-  const auto max_len = std::max(len_xy[0], len_xy[1]);
-  const auto beg = m_qcc_buf.begin();  // First half of the buffer
-  const auto beg2 = beg + max_len;     // Second half of the buffer
-
-  // First, perform IDWT along Y for every column
-  if (len_xy[1] % 2 == 0) {
-    for (size_t x = 0; x < len_xy[0]; x++) {
-      for (size_t y = 0; y < len_xy[1]; y++)
-        m_qcc_buf[y] = *(plane + y * m_dims[0] + x);
-      m_scatter_even(beg, beg + len_xy[1], beg2);
-      this->QccWAVCDF97SynthesisSymmetricEvenEven(m_qcc_buf.data() + max_len, len_xy[1]);
-      for (size_t y = 0; y < len_xy[1]; y++)
-        *(plane + y * m_dims[0] + x) = *(beg2 + y);
-    }
-  }
-  else  // Odd length
-  {
-    for (size_t x = 0; x < len_xy[0]; x++) {
-      for (size_t y = 0; y < len_xy[1]; y++)
-        m_qcc_buf[y] = *(plane + y * m_dims[0] + x);
-      m_scatter_odd(beg, beg + len_xy[1], beg2);
-      this->QccWAVCDF97SynthesisSymmetricOddEven(m_qcc_buf.data() + max_len, len_xy[1]);
-      for (size_t y = 0; y < len_xy[1]; y++)
-        *(plane + y * m_dims[0] + x) = *(beg2 + y);
+template <typename T>
+void sperr::CDF97<T>::m_idwt2d_one_level(itd_type plane, std::array<size_t, 2> len_xy)
+{
+  const auto& k = sperr::lifting_kernels<T>(m_isa);
+  const auto coeffs = LiftingCoeffs<T>{ALPHA, BETA, GAMMA, DELTA, EPSILON, INV_EPSILON};
+  auto* const p = &*plane;
+  const auto stride = m_dims[0];
+
+  // First, perform IDWT along Y for every column, in batches of `LANES` columns.
+  // Low pass coefficients are copied to a buffer first, so the results can be written in place.
+  const auto low_y = len_xy[1] - len_xy[1] / 2;
+  const auto num_batches = (len_xy[0] + LANES - 1) / LANES;
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t batch = 0; batch < num_batches; batch++) {
+    auto& buf = m_lane_buf[thread_id()];
+    const auto x = batch * LANES;
+    const auto lanes = std::min(LANES, len_xy[0] - x);
+    auto* const col = p + x;
+    for (size_t y = 0; y < low_y; y++) {
+      auto pos = col + y * stride;
+      std::copy(pos, pos + lanes, buf.begin() + y * lanes);
     }
+    k.synthesis(buf.data(), lanes, col + low_y * stride, stride, col, stride, len_xy[1], lanes,
+                coeffs);
   }
 
   // Second, perform IDWT along X for every row
-  if (len_xy[0] % 2 == 0) {
-    for (size_t i = 0; i < len_xy[1]; i++) {
-      auto pos = plane + i * m_dims[0];
-      m_scatter_even(pos, pos + len_xy[0], beg);
-      this->QccWAVCDF97SynthesisSymmetricEvenEven(m_qcc_buf.data(), len_xy[0]);
-      std::copy(beg, beg + len_xy[0], pos);
-    }
-  }
-  else  // Odd length
-  {
-    for (size_t i = 0; i < len_xy[1]; i++) {
-      auto pos = plane + i * m_dims[0];
-      m_scatter_odd(pos, pos + len_xy[0], beg);
-      this->QccWAVCDF97SynthesisSymmetricOddEven(m_qcc_buf.data(), len_xy[0]);
-      std::copy(beg, beg + len_xy[0], pos);
-    }
+  const auto low_x = len_xy[0] - len_xy[0] / 2;
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t i = 0; i < len_xy[1]; i++) {
+    auto& buf = m_qcc_buf[thread_id()];
+    auto* const pos = p + i * stride;
+    std::copy(pos, pos + low_x, buf.begin());
+    k.synthesis(buf.data(), 1, pos + low_x, 1, pos, 1, len_xy[0], 1, coeffs);
   }
 }
 
-void sperr::CDF97::m_dwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz)
+template <typename T>
+void sperr::CDF97<T>::m_dwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz)
 {
   // First, do one level of transform on all XY planes.
   const auto plane_size_xy = m_dims[0] * m_dims[1];
@@ -457,97 +604,17 @@ void sperr::CDF97::m_dwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz
     m_dwt2d_one_level(vol + offset, {len_xyz[0], len_xyz[1]});
   }
 
-  const auto beg = m_qcc_buf.begin();  // First half of the buffer
-  const auto beg2 = beg + len_xyz[2];  // Second half of the buffer
-
-  // Second, do one level of transform on all Z columns.  Strategy:
-  // 1) extract a Z column to buffer space `m_qcc_buf`
-  // 2) use appropriate even/odd Qcc*** function to transform it
-  // 3) gather coefficients from `m_qcc_buf` to the second half of `m_qcc_buf`
-  // 4) put the Z column back to their locations as a Z column.
-
-  if (len_xyz[2] % 2 == 0) {  // Even length
-    for (size_t y = 0; y < len_xyz[1]; y++) {
-      for (size_t x = 0; x < len_xyz[0]; x++) {
-        const size_t xy_offset = y * m_dims[0] + x;
-        // Step 1
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_qcc_buf[z] = m_data_buf[z * plane_size_xy + xy_offset];
-        // Step 2
-        this->QccWAVCDF97AnalysisSymmetricEvenEven(m_qcc_buf.data(), len_xyz[2]);
-        // Step 3
-        m_gather_even(beg, beg2, beg2);
-        // Step 4
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_data_buf[z * plane_size_xy + xy_offset] = *(beg2 + z);
-      }
-    }
-  }
-  else {  // Odd length
-    for (size_t y = 0; y < len_xyz[1]; y++) {
-      for (size_t x = 0; x < len_xyz[0]; x++) {
-        const size_t xy_offset = y * m_dims[0] + x;
-        // Step 1
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_qcc_buf[z] = m_data_buf[z * plane_size_xy + xy_offset];
-        // Step 2
-        this->QccWAVCDF97AnalysisSymmetricOddEven(m_qcc_buf.data(), len_xyz[2]);
-        // Step 3
-        m_gather_odd(beg, beg2, beg2);
-        // Step 4
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_data_buf[z * plane_size_xy + xy_offset] = *(beg2 + z);
-      }
-    }
-  }
+  // Second, do one level of transform on all Z columns.
+  m_dwt_z(vol, len_xyz, 1);
 }
 
-void sperr::CDF97::m_idwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz)
+template <typename T>
+void sperr::CDF97<T>::m_idwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xyz)
 {
+  // First, do one level of inverse transform on all Z columns.
+  m_idwt_z(vol, len_xyz, 1);
+
   const auto plane_size_xy = m_dims[0] * m_dims[1];
-  const auto beg = m_qcc_buf.begin();  // First half of the buffer
-  const auto beg2 = beg + len_xyz[2];  // Second half of the buffer
-
-  // First, do one level of inverse transform on all Z columns.  Strategy:
-  // 1) extract a Z column to buffer space `m_qcc_buf`
-  // 2) scatter coefficients from `m_qcc_buf` to the second half of `m_qcc_buf`
-  // 3) use appropriate even/odd Qcc*** function to transform it
-  // 4) put the Z column back to their locations as a Z column.
-
-  if (len_xyz[2] % 2 == 0) {
-    for (size_t y = 0; y < len_xyz[1]; y++) {
-      for (size_t x = 0; x < len_xyz[0]; x++) {
-        const size_t xy_offset = y * m_dims[0] + x;
-        // Step 1
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_qcc_buf[z] = m_data_buf[z * plane_size_xy + xy_offset];
-        // Step 2
-        m_scatter_even(beg, beg2, beg2);
-        // Step 3
-        this->QccWAVCDF97SynthesisSymmetricEvenEven(m_qcc_buf.data() + len_xyz[2], len_xyz[2]);
-        // Step 4
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_data_buf[z * plane_size_xy + xy_offset] = *(beg2 + z);
-      }
-    }
-  }
-  else {
-    for (size_t y = 0; y < len_xyz[1]; y++) {
-      for (size_t x = 0; x < len_xyz[0]; x++) {
-        const size_t xy_offset = y * m_dims[0] + x;
-        // Step 1
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_qcc_buf[z] = m_data_buf[z * plane_size_xy + xy_offset];
-        // Step 2
-        m_scatter_odd(beg, beg2, beg2);
-        // Step 3
-        this->QccWAVCDF97SynthesisSymmetricOddEven(m_qcc_buf.data() + len_xyz[2], len_xyz[2]);
-        // Step 4
-        for (size_t z = 0; z < len_xyz[2]; z++)
-          m_data_buf[z * plane_size_xy + xy_offset] = *(beg2 + z);
-      }
-    }
-  }
 
   // Second, do one level of inverse transform on all XY planes.
   for (size_t z = 0; z < len_xyz[2]; z++) {
@@ -556,67 +623,237 @@ void sperr::CDF97::m_idwt3d_one_level(itd_type vol, std::array<size_t, 3> len_xy
   }
 }
 
-void sperr::CDF97::m_gather_even(citd_type begin, citd_type end, itd_type dest) const
-{
-  auto len = end - begin;
-  assert(len % 2 == 0);  // This function specifically for even length input
-  size_t low_count = len / 2, high_count = len / 2;
-  for (size_t i = 0; i < low_count; i++) {
-    *dest = *(begin + i * 2);
-    ++dest;
-  }
-  for (size_t i = 0; i < high_count; i++) {
-    *dest = *(begin + i * 2 + 1);
-    ++dest;
+template <typename T>
+void sperr::CDF97<T>::m_dwt_z(itd_type vol, std::array<size_t, 3> len_xyz, size_t num_of_xforms)
+{
+  if (num_of_xforms == 0)
+    return;
+
+  // Strategy:
+  // 1) copy a tile of Z columns to the calling thread's `m_lane_buf`, interleaved as lanes;
+  // 2) transform all of them together for `num_of_xforms` levels; low pass results are
+  //    written in place, while high pass results go to the second half of the tile block
+  //    before they're copied back after every level;
+  // 3) put the Z columns back to their locations in the volume.
+  const auto& k = sperr::lifting_kernels<T>(m_isa);
+  const auto coeffs = LiftingCoeffs<T>{ALPHA, BETA, GAMMA, DELTA, EPSILON, INV_EPSILON};
+  const auto plane_size_xy = m_dims[0] * m_dims[1];
+  const auto max_lanes = m_z_tile[0] * m_z_tile[1];
+  for (auto& buf : m_lane_buf) {
+    if (len_xyz[2] * max_lanes * 2 > buf.size())
+      buf.resize(len_xyz[2] * max_lanes * 2);
+  }
+
+  // Tiles are independent, so they're distributed across threads.
+  const auto tiles_x = (len_xyz[0] + m_z_tile[0] - 1) / m_z_tile[0];
+  const auto tiles_y = (len_xyz[1] + m_z_tile[1] - 1) / m_z_tile[1];
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t tile = 0; tile < tiles_x * tiles_y; tile++) {
+    auto& buf = m_lane_buf[thread_id()];
+    const auto x0 = (tile % tiles_x) * m_z_tile[0];
+    const auto y0 = (tile / tiles_x) * m_z_tile[1];
+    const auto tile_x = std::min(m_z_tile[0], len_xyz[0] - x0);
+    const auto tile_y = std::min(m_z_tile[1], len_xyz[1] - y0);
+    const auto lanes = tile_x * tile_y;
+    const auto blk = buf.begin();
+    const auto blk2 = blk + len_xyz[2] * lanes;
+
+    // Step 1
+    for (size_t z = 0; z < len_xyz[2]; z++) {
+      for (size_t y = 0; y < tile_y; y++) {
+        auto pos = vol + z * plane_size_xy + (y0 + y) * m_dims[0] + x0;
+        std::copy(pos, pos + tile_x, blk + z * lanes + y * tile_x);
+      }
+    }
+
+    // Step 2
+    for (size_t lev = 0; lev < num_of_xforms; lev++) {
+      const auto len = sperr::calc_approx_detail_len(len_xyz[2], lev)[0];
+      const auto low_len = len - len / 2;
+      k.analysis(&*blk, lanes, &*blk, lanes, &*blk2, lanes, len, lanes, coeffs);
+      std::copy(blk2, blk2 + len / 2 * lanes, blk + low_len * lanes);
+    }
+
+    // Step 3
+    for (size_t z = 0; z < len_xyz[2]; z++) {
+      for (size_t y = 0; y < tile_y; y++) {
+        auto src = blk + z * lanes + y * tile_x;
+        std::copy(src, src + tile_x, vol + z * plane_size_xy + (y0 + y) * m_dims[0] + x0);
+      }
+    }
   }
 }
 
-void sperr::CDF97::m_gather_odd(citd_type begin, citd_type end, itd_type dest) const
+template <typename T>
+void sperr::CDF97<T>::m_idwt_z(itd_type vol, std::array<size_t, 3> len_xyz, size_t num_of_xforms)
 {
-  auto len = end - begin;
-  assert(len % 2 == 1);  // This function specifically for odd length input
-  size_t low_count = len / 2 + 1, high_count = len / 2;
-  for (size_t i = 0; i < low_count; i++) {
-    *dest = *(begin + i * 2);
-    ++dest;
-  }
-  for (size_t i = 0; i < high_count; i++) {
-    *dest = *(begin + i * 2 + 1);
-    ++dest;
+  if (num_of_xforms == 0)
+    return;
+
+  // Strategy: same as `m_dwt_z()`, but copying low pass coefficients to the second half of
+  //    the tile block before every level of inverse transform.
+  const auto& k = sperr::lifting_kernels<T>(m_isa);
+  const auto coeffs = LiftingCoeffs<T>{ALPHA, BETA, GAMMA, DELTA, EPSILON, INV_EPSILON};
+  const auto plane_size_xy = m_dims[0] * m_dims[1];
+  const auto max_lanes = m_z_tile[0] * m_z_tile[1];
+  for (auto& buf : m_lane_buf) {
+    if (len_xyz[2] * max_lanes * 2 > buf.size())
+      buf.resize(len_xyz[2] * max_lanes * 2);
+  }
+
+  // Tiles are independent, so they're distributed across threads.
+  const auto tiles_x = (len_xyz[0] + m_z_tile[0] - 1) / m_z_tile[0];
+  const auto tiles_y = (len_xyz[1] + m_z_tile[1] - 1) / m_z_tile[1];
+#pragma omp parallel for num_threads(m_num_threads)
+  for (size_t tile = 0; tile < tiles_x * tiles_y; tile++) {
+    auto& buf = m_lane_buf[thread_id()];
+    const auto x0 = (tile % tiles_x) * m_z_tile[0];
+    const auto y0 = (tile / tiles_x) * m_z_tile[1];
+    const auto tile_x = std::min(m_z_tile[0], len_xyz[0] - x0);
+    const auto tile_y = std::min(m_z_tile[1], len_xyz[1] - y0);
+    const auto lanes = tile_x * tile_y;
+    const auto blk = buf.begin();
+    const auto blk2 = blk + len_xyz[2] * lanes;
+
+    for (size_t z = 0; z < len_xyz[2]; z++) {
+      for (size_t y = 0; y < tile_y; y++) {
+        auto pos = vol + z * plane_size_xy + (y0 + y) * m_dims[0] + x0;
+        std::copy(pos, pos + tile_x, blk + z * lanes + y * tile_x);
+      }
+    }
+
+    for (size_t lev = num_of_xforms; lev > 0; lev--) {
+      const auto len = sperr::calc_approx_detail_len(len_xyz[2], lev - 1)[0];
+      const auto low_len = len - len / 2;
+      std::copy(blk, blk + low_len * lanes, blk2);
+      k.synthesis(&*blk2, lanes, &*blk + low_len * lanes, lanes, &*blk, lanes, len, lanes, coeffs);
+    }
+
+    for (size_t z = 0; z < len_xyz[2]; z++) {
+      for (size_t y = 0; y < tile_y; y++) {
+        auto src = blk + z * lanes + y * tile_x;
+        std::copy(src, src + tile_x, vol + z * plane_size_xy + (y0 + y) * m_dims[0] + x0);
+      }
+    }
   }
 }
 
-void sperr::CDF97::m_scatter_even(citd_type begin, citd_type end, itd_type dest) const
-{
-  auto len = end - begin;
-  assert(len % 2 == 0);  // This function specifically for even length input
-  size_t low_count = len / 2, high_count = len / 2;
-  for (size_t i = 0; i < low_count; i++) {
-    *(dest + i * 2) = *begin;
-    ++begin;
-  }
-  for (size_t i = 0; i < high_count; i++) {
-    *(dest + i * 2 + 1) = *begin;
-    ++begin;
+template <typename T>
+auto sperr::CDF97<T>::m_idwt_region(const T* src,
+                                    dims_type src_dims,
+                                    std::array<size_t, 6> box,
+                                    std::array<bool, 3> axes,
+                                    size_t num_xforms) const -> vec_type<T>
+{
+  assert(axes[0] == axes[1]);
+
+  // Copy a box of `src_vol` (with dimension `src_d`) to `dst`, which is exactly the box size.
+  auto copy_box = [](const T* src_vol, dims_type src_d, std::array<size_t, 6> b, T* dst) {
+    for (size_t z = 0; z < b[5]; z++) {
+      for (size_t y = 0; y < b[3]; y++) {
+        const auto* row = src_vol + ((b[4] + z) * src_d[1] + b[2] + y) * src_d[0] + b[0];
+        dst = std::copy(row, row + b[1], dst);
+      }
+    }
+  };
+
+  // `ins[lev]` is the box of the approximation at level `lev` that is inverse transformed, and
+  //    `outs[lev]` is the box that is needed from it. `outs[lev + 1]` then consists of the low
+  //    pass coefficients of `ins[lev]`. Axes that aren't transformed keep the same range.
+  auto ins = std::vector<std::array<size_t, 6>>(num_xforms);
+  auto outs = std::vector<std::array<size_t, 6>>(num_xforms + 1, box);
+  auto lens = std::vector<dims_type>(num_xforms, src_dims);
+  for (size_t i = 0; i < 3; i++) {
+    auto ranges = std::vector<std::array<size_t, 2>>(num_xforms, {box[i * 2], box[i * 2 + 1]});
+    if (axes[i])
+      ranges = region_ranges(src_dims[i], box[i * 2], box[i * 2 + 1], num_xforms);
+    for (size_t lev = 0; lev < num_xforms; lev++) {
+      const auto [beg, len] = ranges[lev];
+      ins[lev][i * 2] = beg;
+      ins[lev][i * 2 + 1] = len;
+      if (axes[i]) {
+        lens[lev][i] = sperr::calc_approx_detail_len(src_dims[i], lev)[0];
+        outs[lev + 1][i * 2] = beg / 2;
+        outs[lev + 1][i * 2 + 1] = len - len / 2;
+      }
+    }
   }
-}
 
-void sperr::CDF97::m_scatter_odd(citd_type begin, citd_type end, itd_type dest) const
-{
-  auto len = end - begin;
-  assert(len % 2 == 1);  // This function specifically for odd length input
-  size_t low_count = len / 2 + 1, high_count = len / 2;
-  for (size_t i = 0; i < low_count; i++) {
-    *(dest + i * 2) = *begin;
-    ++begin;
+  auto cur = vec_type<T>(box[1] * box[3] * box[5]);
+  if (num_xforms == 0) {
+    copy_box(src, src_dims, box, cur.data());
+    return cur;
   }
-  for (size_t i = 0; i < high_count; i++) {
-    *(dest + i * 2 + 1) = *begin;
-    ++begin;
+
+  // Reconstruct from the coarsest level. At every level, the low pass coefficients (along all
+  //    transformed axes) come from the reconstruction of the coarser level, and the rest come
+  //    from `src`. They're gathered in the same layout as a full volume has, so that one level
+  //    of inverse transform can be carried out by a smaller CDF97 object.
+  auto sub = CDF97<T>();
+  sub.m_isa = m_isa;
+  sub.m_num_threads = m_num_threads;
+  sub.m_z_tile = m_z_tile;
+  for (size_t lev = num_xforms; lev > 0; lev--) {
+    const auto& in = ins[lev - 1];
+    const auto& low = outs[lev];
+    const auto& len = lens[lev - 1];
+    const auto sub_dims = dims_type{in[1], in[3], in[5]};
+
+    // Map position `p` along axis `i` of `in` to its index in the approximation at this level,
+    //    and tell if it's a low pass coefficient.
+    auto locate = [&](size_t i, size_t p) -> std::pair<size_t, bool> {
+      const auto num_low = in[i * 2 + 1] - in[i * 2 + 1] / 2;
+      if (!axes[i])
+        return {in[i * 2] + p, true};
+      else if (p < num_low)
+        return {in[i * 2] / 2 + p, true};
+      else
+        return {len[i] - len[i] / 2 + in[i * 2] / 2 + p - num_low, false};
+    };
+
+    auto buf = vec_type<T>(sub_dims[0] * sub_dims[1] * sub_dims[2]);
+    auto dst = buf.begin();
+    const auto num_low_x = axes[0] ? sub_dims[0] - sub_dims[0] / 2 : sub_dims[0];
+    const auto low_x = locate(0, 0).first;
+    const auto high_x = locate(0, num_low_x).first;
+    for (size_t z = 0; z < sub_dims[2]; z++) {
+      const auto [src_z, low_z] = locate(2, z);
+      for (size_t y = 0; y < sub_dims[1]; y++) {
+        const auto [src_y, low_y] = locate(1, y);
+        const auto* row = src + (src_z * src_dims[1] + src_y) * src_dims[0];
+        if (low_y && low_z && lev < num_xforms) {
+          const auto* cur_row = cur.data() + ((src_z - low[4]) * low[3] + src_y - low[2]) * low[1];
+          dst = std::copy(cur_row, cur_row + num_low_x, dst);
+        }
+        else
+          dst = std::copy(row + low_x, row + low_x + num_low_x, dst);
+        dst = std::copy(row + high_x, row + high_x + sub_dims[0] - num_low_x, dst);
+      }
+    }
+
+    sub.take_data(std::move(buf), sub_dims);
+    const auto vol = sub.m_data_buf.begin();
+    if (axes[2] && axes[0])
+      sub.m_idwt3d_one_level(vol, sub_dims);
+    else if (axes[2])
+      sub.m_idwt_z(vol, sub_dims, 1);
+    else {
+      for (size_t z = 0; z < sub_dims[2]; z++)
+        sub.m_idwt2d_one_level(vol + z * sub_dims[0] * sub_dims[1], {sub_dims[0], sub_dims[1]});
+    }
+
+    // Keep only the box needed by the finer level.
+    const auto& out = outs[lev - 1];
+    cur.resize(out[1] * out[3] * out[5]);
+    copy_box(sub.m_data_buf.data(), sub_dims,
+             {out[0] - in[0], out[1], out[2] - in[2], out[3], out[4] - in[4], out[5]}, cur.data());
   }
+
+  return cur;
 }
 
-auto sperr::CDF97::m_sub_slice(std::array<size_t, 2> subdims) const -> vecd_type
+template <typename T>
+auto sperr::CDF97<T>::m_sub_slice(std::array<size_t, 2> subdims) const -> vecd_type
 {
   assert(subdims[0] <= m_dims[0] && subdims[1] <= m_dims[1]);
 
@@ -631,7 +868,8 @@ auto sperr::CDF97::m_sub_slice(std::array<size_t, 2> subdims) const -> vecd_type
   return ret;
 }
 
-void sperr::CDF97::m_sub_volume(dims_type subdims, itd_type dst) const
+template <typename T>
+void sperr::CDF97<T>::m_sub_volume(dims_type subdims, vecd_type::iterator dst) const
 {
   assert(subdims[0] <= m_dims[0] && subdims[1] <= m_dims[1] && subdims[2] <= m_dims[2]);
 
@@ -645,111 +883,10 @@ void sperr::CDF97::m_sub_volume(dims_type subdims, itd_type dst) const
   }
 }
 
-//
-// Methods from QccPack
-//
-void sperr::CDF97::QccWAVCDF97AnalysisSymmetricEvenEven(double* signal, size_t signal_length)
-{
-  for (size_t i = 1; i < signal_length - 2; i += 2)
-    signal[i] += ALPHA * (signal[i - 1] + signal[i + 1]);
-
-  signal[signal_length - 1] += 2.0 * ALPHA * signal[signal_length - 2];
-
-  signal[0] += 2.0 * BETA * signal[1];
+template class sperr::CDF97<float>;
+template class sperr::CDF97<double>;
 
-  for (size_t i = 2; i < signal_length; i += 2)
-    signal[i] += BETA * (signal[i + 1] + signal[i - 1]);
-
-  for (size_t i = 1; i < signal_length - 2; i += 2)
-    signal[i] += GAMMA * (signal[i - 1] + signal[i + 1]);
-
-  signal[signal_length - 1] += 2.0 * GAMMA * signal[signal_length - 2];
-
-  signal[0] = EPSILON * (signal[0] + 2.0 * DELTA * signal[1]);
-
-  for (size_t i = 2; i < signal_length; i += 2)
-    signal[i] = EPSILON * (signal[i] + DELTA * (signal[i + 1] + signal[i - 1]));
-
-  for (size_t i = 1; i < signal_length; i += 2)
-    signal[i] *= -INV_EPSILON;
-}
-
-void sperr::CDF97::QccWAVCDF97SynthesisSymmetricEvenEven(double* signal, size_t signal_length)
-{
-  for (size_t i = 1; i < signal_length; i += 2)
-    signal[i] *= (-EPSILON);
-
-  signal[0] = signal[0] * INV_EPSILON - 2.0 * DELTA * signal[1];
-
-  for (size_t i = 2; i < signal_length; i += 2)
-    signal[i] = signal[i] * INV_EPSILON - DELTA * (signal[i + 1] + signal[i - 1]);
-
-  for (size_t i = 1; i < signal_length - 2; i += 2)
-    signal[i] -= GAMMA * (signal[i - 1] + signal[i + 1]);
-
-  signal[signal_length - 1] -= 2.0 * GAMMA * signal[signal_length - 2];
-
-  signal[0] -= 2.0 * BETA * signal[1];
-
-  for (size_t i = 2; i < signal_length; i += 2)
-    signal[i] -= BETA * (signal[i + 1] + signal[i - 1]);
-
-  for (size_t i = 1; i < signal_length - 2; i += 2)
-    signal[i] -= ALPHA * (signal[i - 1] + signal[i + 1]);
-
-  signal[signal_length - 1] -= 2.0 * ALPHA * signal[signal_length - 2];
-}
-
-void sperr::CDF97::QccWAVCDF97SynthesisSymmetricOddEven(double* signal, size_t signal_length)
-{
-  for (size_t i = 1; i < signal_length - 1; i += 2)
-    signal[i] *= (-EPSILON);
-
-  signal[0] = signal[0] * INV_EPSILON - 2.0 * DELTA * signal[1];
-
-  for (size_t i = 2; i < signal_length - 2; i += 2)
-    signal[i] = signal[i] * INV_EPSILON - DELTA * (signal[i + 1] + signal[i - 1]);
-
-  signal[signal_length - 1] =
-      signal[signal_length - 1] * INV_EPSILON - 2.0 * DELTA * signal[signal_length - 2];
-
-  for (size_t i = 1; i < signal_length - 1; i += 2)
-    signal[i] -= GAMMA * (signal[i - 1] + signal[i + 1]);
-
-  signal[0] -= 2.0 * BETA * signal[1];
-
-  for (size_t i = 2; i < signal_length - 2; i += 2)
-    signal[i] -= BETA * (signal[i + 1] + signal[i - 1]);
-
-  signal[signal_length - 1] -= 2.0 * BETA * signal[signal_length - 2];
-
-  for (size_t i = 1; i < signal_length - 1; i += 2)
-    signal[i] -= ALPHA * (signal[i - 1] + signal[i + 1]);
-}
-
-void sperr::CDF97::QccWAVCDF97AnalysisSymmetricOddEven(double* signal, size_t signal_length)
-{
-  for (size_t i = 1; i < signal_length - 1; i += 2)
-    signal[i] += ALPHA * (signal[i - 1] + signal[i + 1]);
-
-  signal[0] += 2.0 * BETA * signal[1];
-
-  for (size_t i = 2; i < signal_length - 2; i += 2)
-    signal[i] += BETA * (signal[i + 1] + signal[i - 1]);
-
-  signal[signal_length - 1] += 2.0 * BETA * signal[signal_length - 2];
-
-  for (size_t i = 1; i < signal_length - 1; i += 2)
-    signal[i] += GAMMA * (signal[i - 1] + signal[i + 1]);
-
-  signal[0] = EPSILON * (signal[0] + 2.0 * DELTA * signal[1]);
-
-  for (size_t i = 2; i < signal_length - 2; i += 2)
-    signal[i] = EPSILON * (signal[i] + DELTA * (signal[i + 1] + signal[i - 1]));
-
-  signal[signal_length - 1] =
-      EPSILON * (signal[signal_length - 1] + 2.0 * DELTA * signal[signal_length - 2]);
-
-  for (size_t i = 1; i < signal_length - 1; i += 2)
-    signal[i] *= (-INV_EPSILON);
-}
+template auto sperr::CDF97<float>::copy_data(const float*, size_t, dims_type) -> RTNType;
+template auto sperr::CDF97<float>::copy_data(const double*, size_t, dims_type) -> RTNType;
+template auto sperr::CDF97<double>::copy_data(const float*, size_t, dims_type) -> RTNType;
+template auto sperr::CDF97<double>::copy_data(const double*, size_t, dims_type) -> RTNType;
@@ -0,0 +1,834 @@
+#include "CDF97_Kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+
+#ifdef USE_SIMD
+// Same as in Quantize_Kernels.cpp, GCC 12 warns about the intentionally undefined vectors in
+//    its AVX-512 intrinsic headers; silence that within the headers only.
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+//
+// Note on bit-identical results: this file is compiled with floating-point contraction
+//    turned off (see src/CMakeLists.txt), so that a multiplication followed by an addition
+//    is never fused into an FMA instruction in any of the kernels.
+//
+// The kernels below are written once and compiled for every instruction set, which requires
+//    them to be inlined into the functions that enable each instruction set. Once inlined,
+//    no SIMD vector is passed across a function boundary, so the ABI warnings that GCC issues
+//    on these templates don't apply.
+//
+#if defined(__GNUC__)
+#define SPERR_FORCE_INLINE [[gnu::always_inline]] inline
+#else
+#define SPERR_FORCE_INLINE inline
+#endif
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wpsabi"
+#endif
+
+namespace {
+
+//
+// Vector operations used by the kernels. Each vector holds `W` values, and
+//    - `unzip_even(a, b)` and `unzip_odd(a, b)` pick the even and odd elements of a followed
+//      by b, and `zip_lo(e, o)` and `zip_hi(e, o)` interleave them back;
+//    - `succ(a, b)` is the successor of every element in a, i.e., a[1], ..., a[W - 1], b[0];
+//    - `pred(a, b)` is the predecessor of every element in b, i.e., a[W - 1], b[0], ...;
+//    - `bcast0(a)` has every element equal to a[0].
+// `Scalar` and `Array` are for instruction sets without their own vector operations, and
+//    only provide the arithmetic operations. The compiler is free to vectorize the loops in
+//    `Array`, as the elements don't depend on each other.
+//
+template <typename T>
+struct Scalar {
+  using V = T;
+  static constexpr size_t W = 1;
+  static V load(const T* p) { return *p; }
+  static void store(T* p, V a) { *p = a; }
+  static V set1(T c) { return c; }
+  static V add(V a, V b) { return a + b; }
+  static V sub(V a, V b) { return a - b; }
+  static V mul(V a, V b) { return a * b; }
+};
+
+template <typename T, size_t N>
+struct Array {
+  using V = std::array<T, N>;
+  static constexpr size_t W = N;
+  static V load(const T* p)
+  {
+    V r;
+    std::copy(p, p + N, r.begin());
+    return r;
+  }
+  static void store(T* p, const V& a) { std::copy(a.begin(), a.end(), p); }
+  static V set1(T c)
+  {
+    V r;
+    r.fill(c);
+    return r;
+  }
+  static V add(const V& a, const V& b)
+  {
+    V r;
+    for (size_t i = 0; i < N; i++)
+      r[i] = a[i] + b[i];
+    return r;
+  }
+  static V sub(const V& a, const V& b)
+  {
+    V r;
+    for (size_t i = 0; i < N; i++)
+      r[i] = a[i] - b[i];
+    return r;
+  }
+  static V mul(const V& a, const V& b)
+  {
+    V r;
+    for (size_t i = 0; i < N; i++)
+      r[i] = a[i] * b[i];
+    return r;
+  }
+};
+
+//
+// Fused kernels on interleaved signals (lanes).
+//    All lifting steps of one level of transform are carried out in a single sweep, keeping
+//    a small window of intermediate values of the steps that lag behind. The low and high
+//    pass results are written to their own bands as soon as they're final, so no separate
+//    pass is needed to gather or scatter them. Every value goes through exactly the same
+//    operations as in QccPack.
+//
+//    Each element is a vector of `Vec::W` contiguous lanes, and element `i` of the input starts
+//    from `src + i * src_stride`, and so on.
+//
+// Notation: x[k] and y[k] are the even and odd elements of a signal, and the number after them
+//    indicates the lifting step that they've gone through.
+//
+template <typename Vec, typename T>
+SPERR_FORCE_INLINE void analysis_fused(const T* src,
+                                       size_t src_stride,
+                                       T* low,
+                                       size_t low_stride,
+                                       T* high,
+                                       size_t high_stride,
+                                       size_t len,
+                                       const sperr::LiftingCoeffs<T>& c)
+{
+  assert(len >= 4);
+  const size_t K = len / 2;  // number of odd elements
+  const bool is_odd = len % 2;
+  const auto A = Vec::set1(c.alpha), B = Vec::set1(c.beta), G = Vec::set1(c.gamma);
+  const auto D = Vec::set1(c.delta), E = Vec::set1(c.epsilon);
+  const auto A2 = Vec::set1(T{2} * c.alpha), B2 = Vec::set1(T{2} * c.beta);
+  const auto G2 = Vec::set1(T{2} * c.gamma), D2 = Vec::set1(T{2} * c.delta);
+  const auto NIE = Vec::set1(-c.inv_epsilon);
+
+  // x0 is x[k] before lifting, and the others are the latest values of each step.
+  auto x0 = Vec::load(src);
+  auto y1 = x0, x2 = x0, y3 = x0;
+
+  for (size_t k = 0; k < K; k++) {
+    const T* const py = src + (2 * k + 1) * src_stride;
+    auto y1_k = Vec::load(py);
+    auto xn = x0;
+    if (is_odd || k + 1 < K) {
+      xn = Vec::load(py + src_stride);
+      y1_k = Vec::add(y1_k, Vec::mul(A, Vec::add(x0, xn)));
+    }
+    else
+      y1_k = Vec::add(y1_k, Vec::mul(A2, x0));
+
+    if (k == 0)
+      x2 = Vec::add(x0, Vec::mul(B2, y1_k));
+    else {
+      const auto x2_k = Vec::add(x0, Vec::mul(B, Vec::add(y1, y1_k)));
+
+      // Finalize x[k - 1] and y[k - 1].
+      const auto y3_k1 = Vec::add(y1, Vec::mul(G, Vec::add(x2, x2_k)));
+      if (k == 1)
+        Vec::store(low, Vec::mul(E, Vec::add(x2, Vec::mul(D2, y3_k1))));
+      else {
+        const auto x4 = Vec::mul(E, Vec::add(x2, Vec::mul(D, Vec::add(y3, y3_k1))));
+        Vec::store(low + (k - 1) * low_stride, x4);
+      }
+      Vec::store(high + (k - 1) * high_stride, Vec::mul(y3_k1, NIE));
+      y3 = y3_k1;
+      x2 = x2_k;
+    }
+    y1 = y1_k;
+    x0 = xn;
+  }
+
+  // Finalize x[K - 1] and y[K - 1], and x[K] if the length is odd.
+  T* const pl = low + (K - 1) * low_stride;
+  T* const ph = high + (K - 1) * high_stride;
+  if (is_odd) {
+    const auto x2_k = Vec::add(x0, Vec::mul(B2, y1));
+    const auto y3_k1 = Vec::add(y1, Vec::mul(G, Vec::add(x2, x2_k)));
+    Vec::store(pl, Vec::mul(E, Vec::add(x2, Vec::mul(D, Vec::add(y3, y3_k1)))));
+    Vec::store(ph, Vec::mul(y3_k1, NIE));
+    Vec::store(pl + low_stride, Vec::mul(E, Vec::add(x2_k, Vec::mul(D2, y3_k1))));
+  }
+  else {
+    const auto y3_k1 = Vec::add(y1, Vec::mul(G2, x2));
+    Vec::store(pl, Vec::mul(E, Vec::add(x2, Vec::mul(D, Vec::add(y3, y3_k1)))));
+    Vec::store(ph, Vec::mul(y3_k1, NIE));
+  }
+}
+
+template <typename Vec, typename T>
+SPERR_FORCE_INLINE void synthesis_fused(const T* low,
+                                        size_t low_stride,
+                                        const T* high,
+                                        size_t high_stride,
+                                        T* dst,
+                                        size_t dst_stride,
+                                        size_t len,
+                                        const sperr::LiftingCoeffs<T>& c)
+{
+  // Results of x[k] and y[k] are written after x[k + 2] and y[k + 2] are read, so `dst` may
+  //    overlap the part of `high` that's already been read.
+  assert(len >= 4);
+  const size_t K = len / 2;
+  const bool is_odd = len % 2;
+  const auto IE = Vec::set1(c.inv_epsilon);
+  const auto A2 = Vec::set1(T{2} * c.alpha), B2 = Vec::set1(T{2} * c.beta);
+  const auto G2 = Vec::set1(T{2} * c.gamma), D2 = Vec::set1(T{2} * c.delta);
+  const auto NE = Vec::set1(-c.epsilon), ND = Vec::set1(-c.delta), NG = Vec::set1(-c.gamma);
+  const auto NB = Vec::set1(-c.beta), NA = Vec::set1(-c.alpha);
+
+  // The latest values of each step.
+  auto y1 = Vec::load(high);
+  auto x2 = y1, y3 = y1, x4 = y1;
+
+  for (size_t k = 0; k < K; k++) {
+    const auto y1_k = Vec::mul(Vec::load(high + k * high_stride), NE);
+    const auto x0 = Vec::load(low + k * low_stride);
+    if (k == 0)
+      x2 = Vec::sub(Vec::mul(x0, IE), Vec::mul(D2, y1_k));
+    else {
+      const auto x2_k = Vec::add(Vec::mul(IE, x0), Vec::mul(ND, Vec::add(y1, y1_k)));
+      const auto y3_k1 = Vec::add(y1, Vec::mul(NG, Vec::add(x2, x2_k)));
+      if (k == 1)
+        x4 = Vec::sub(x2, Vec::mul(B2, y3_k1));
+      else {
+        const auto x4_k1 = Vec::add(x2, Vec::mul(NB, Vec::add(y3, y3_k1)));
+
+        // Finalize x[k - 2] and y[k - 2].
+        T* const pd = dst + (2 * k - 4) * dst_stride;
+        Vec::store(pd, x4);
+        Vec::store(pd + dst_stride, Vec::add(y3, Vec::mul(NA, Vec::add(x4, x4_k1))));
+        x4 = x4_k1;
+      }
+      y3 = y3_k1;
+      x2 = x2_k;
+    }
+    y1 = y1_k;
+  }
+
+  // Finalize the last two pairs of elements, and x[K] if the length is odd.
+  T* const pd = dst + (2 * K - 4) * dst_stride;
+  if (is_odd) {
+    const auto x2_k = Vec::sub(Vec::mul(Vec::load(low + K * low_stride), IE), Vec::mul(D2, y1));
+    const auto y3_k1 = Vec::add(y1, Vec::mul(NG, Vec::add(x2, x2_k)));
+    const auto x4_k1 = Vec::add(x2, Vec::mul(NB, Vec::add(y3, y3_k1)));
+    const auto x4_k = Vec::sub(x2_k, Vec::mul(B2, y3_k1));
+    Vec::store(pd, x4);
+    Vec::store(pd + dst_stride, Vec::add(y3, Vec::mul(NA, Vec::add(x4, x4_k1))));
+    Vec::store(pd + 2 * dst_stride, x4_k1);
+    Vec::store(pd + 3 * dst_stride, Vec::add(y3_k1, Vec::mul(NA, Vec::add(x4_k1, x4_k))));
+    Vec::store(pd + 4 * dst_stride, x4_k);
+  }
+  else {
+    const auto y3_k1 = Vec::sub(y1, Vec::mul(G2, x2));
+    const auto x4_k1 = Vec::add(x2, Vec::mul(NB, Vec::add(y3, y3_k1)));
+    Vec::store(pd, x4);
+    Vec::store(pd + dst_stride, Vec::add(y3, Vec::mul(NA, Vec::add(x4, x4_k1))));
+    Vec::store(pd + 2 * dst_stride, x4_k1);
+    Vec::store(pd + 3 * dst_stride, Vec::sub(y3_k1, Vec::mul(A2, x4_k1)));
+  }
+}
+
+//
+// Fused kernels on a single signal.
+//    Every lifting step is a stencil on the results of the step before it, so `Vec::W`
+//    consecutive pairs of elements (a block) go through a step together, with the neighbors
+//    of the first and last pair picked from adjacent blocks by `pred()` and `succ()`. A step
+//    that needs the next block lags one block behind the step before it.
+//
+//    Both ends of the signal are extended symmetrically, so that the general form of each
+//    step also works on the first and last pairs, e.g., y + a * (x + x) on the boundary is the
+//    same as y + (2 * a) * x used in QccPack, because scaling by 2 is exact. On the left end,
+//    this extension is done by `bcast0()` on the first block; on the right end, the last few
+//    blocks are read from a copy of the signal extended beyond its end.
+//
+template <typename Vec, typename T>
+SPERR_FORCE_INLINE void analysis_row(const T* src,
+                                     T* low,
+                                     T* high,
+                                     size_t len,
+                                     const sperr::LiftingCoeffs<T>& c)
+{
+  constexpr size_t W = Vec::W;
+  assert(len >= 4 * W);
+  const size_t num_high = len / 2;
+  const size_t num_low = len - num_high;
+  const size_t num_blocks = (num_low + W - 1) / W + 2;  // every block has 2 * W input elements
+  const size_t num_direct = len / (2 * W);              // blocks that are read from `src`
+  const auto A = Vec::set1(c.alpha), B = Vec::set1(c.beta), G = Vec::set1(c.gamma);
+  const auto D = Vec::set1(c.delta), E = Vec::set1(c.epsilon);
+  const auto NIE = Vec::set1(-c.inv_epsilon);
+
+  // Prepare the extended blocks before anything is written to `low`, which may be `src`.
+  //    Element n beyond the end of the signal is element 2 * (len - 1) - n.
+  T ext[6 * W];
+  assert(num_blocks - num_direct <= 3);
+  for (size_t i = 0; i < (num_blocks - num_direct) * 2 * W; i++) {
+    const size_t n = num_direct * 2 * W + i;
+    if (n < len)
+      ext[i] = src[n];
+    else if (n < 2 * len - 1)
+      ext[i] = src[2 * len - 2 - n];
+    else
+      ext[i] = 0;
+  }
+
+  // Results of block j - 1 (x0, y0) and block j - 2 (y1, x2, and y3 of block j - 3).
+  auto x0_1 = Vec::set1(0), y0_1 = x0_1;
+  auto y1_2 = x0_1, x2_2 = x0_1, y3_3 = x0_1;
+
+  for (size_t j = 0; j < num_blocks; j++) {
+    const T* const p = j < num_direct ? src + j * 2 * W : ext + (j - num_direct) * 2 * W;
+    const auto in0 = Vec::load(p);
+    const auto in1 = Vec::load(p + W);
+    const auto x0 = Vec::unzip_even(in0, in1);
+    const auto y0 = Vec::unzip_odd(in0, in1);
+
+    if (j > 0) {
+      // Lifting steps 1 and 2 on block j - 1.
+      const auto y1 = Vec::add(y0_1, Vec::mul(A, Vec::add(x0_1, Vec::succ(x0_1, x0))));
+      if (j == 1)
+        y1_2 = Vec::bcast0(y1);
+      const auto x2 = Vec::add(x0_1, Vec::mul(B, Vec::add(Vec::pred(y1_2, y1), y1)));
+
+      if (j > 1) {
+        // Lifting steps 3 and 4 on block j - 2, which are then final.
+        const auto y3 = Vec::add(y1_2, Vec::mul(G, Vec::add(x2_2, Vec::succ(x2_2, x2))));
+        if (j == 2)
+          y3_3 = Vec::bcast0(y3);
+        const auto x4 =
+            Vec::mul(E, Vec::add(x2_2, Vec::mul(D, Vec::add(Vec::pred(y3_3, y3), y3))));
+        const auto y4 = Vec::mul(y3, NIE);
+
+        const size_t k = (j - 2) * W;
+        if (k + W <= num_high) {
+          Vec::store(low + k, x4);
+          Vec::store(high + k, y4);
+        }
+        else {
+          T out[2 * W];
+          Vec::store(out, x4);
+          Vec::store(out + W, y4);
+          std::copy(out, out + std::min(W, num_low - k), low + k);
+          if (k < num_high)
+            std::copy(out + W, out + W + (num_high - k), high + k);
+        }
+        y3_3 = y3;
+      }
+      y1_2 = y1;
+      x2_2 = x2;
+    }
+    x0_1 = x0;
+    y0_1 = y0;
+  }
+}
+
+template <typename Vec, typename T>
+SPERR_FORCE_INLINE void synthesis_row(const T* low,
+                                      const T* high,
+                                      T* dst,
+                                      size_t len,
+                                      const sperr::LiftingCoeffs<T>& c)
+{
+  constexpr size_t W = Vec::W;
+  assert(len >= 4 * W);
+  const size_t num_high = len / 2;
+  const size_t num_low = len - num_high;
+  const size_t num_blocks = (num_low + W - 1) / W + 2;  // every block has W low and W high
+  const size_t direct_low = num_low / W;                // blocks that are read from `low`
+  const size_t direct_high = num_high / W;              // blocks that are read from `high`
+  const auto IE = Vec::set1(c.inv_epsilon);
+  const auto NE = Vec::set1(-c.epsilon), ND = Vec::set1(-c.delta), NG = Vec::set1(-c.gamma);
+  const auto NB = Vec::set1(-c.beta), NA = Vec::set1(-c.alpha);
+
+  // Prepare the extended blocks before anything is written to `dst`, which may overlap `high`.
+  //    Element n beyond the end of the interleaved signal is element 2 * (len - 1) - n.
+  T ext_low[4 * W], ext_high[4 * W];
+  assert(num_blocks - direct_high <= 4);
+  for (size_t i = 0; i < (num_blocks - direct_low) * W; i++) {
+    const size_t m = direct_low * W + i;
+    ext_low[i] = m < num_low ? low[m] : (m < len ? low[len - 1 - m] : 0);
+  }
+  for (size_t i = 0; i < (num_blocks - direct_high) * W; i++) {
+    const size_t m = direct_high * W + i;
+    ext_high[i] = m < num_high ? high[m] : (m + 1 < len ? high[len - 2 - m] : 0);
+  }
+
+  // Results of block j - 1 (y1, x2) and block j - 2 (y3, x4).
+  auto y1_1 = Vec::set1(0), x2_1 = y1_1;
+  auto y3_2 = y1_1, x4_2 = y1_1;
+
+  for (size_t j = 0; j < num_blocks; j++) {
+    const T* const pl = j < direct_low ? low + j * W : ext_low + (j - direct_low) * W;
+    const T* const ph = j < direct_high ? high + j * W : ext_high + (j - direct_high) * W;
+
+    // Lifting steps 1 and 2 on block j.
+    const auto y1 = Vec::mul(Vec::load(ph), NE);
+    if (j == 0)
+      y1_1 = Vec::bcast0(y1);
+    const auto x2 =
+        Vec::add(Vec::mul(IE, Vec::load(pl)), Vec::mul(ND, Vec::add(Vec::pred(y1_1, y1), y1)));
+
+    if (j > 0) {
+      // Lifting steps 3 and 4 on block j - 1.
+      const auto y3 = Vec::add(y1_1, Vec::mul(NG, Vec::add(x2_1, Vec::succ(x2_1, x2))));
+      if (j == 1)
+        y3_2 = Vec::bcast0(y3);
+      const auto x4 = Vec::add(x2_1, Vec::mul(NB, Vec::add(Vec::pred(y3_2, y3), y3)));
+
+      if (j > 1) {
+        // Lifting step 5 on block j - 2, which is then final.
+        const auto y5 = Vec::add(y3_2, Vec::mul(NA, Vec::add(x4_2, Vec::succ(x4_2, x4))));
+        const size_t n = (j - 2) * 2 * W;
+        if (n + 2 * W <= len) {
+          Vec::store(dst + n, Vec::zip_lo(x4_2, y5));
+          Vec::store(dst + n + W, Vec::zip_hi(x4_2, y5));
+        }
+        else {
+          T out[2 * W];
+          Vec::store(out, Vec::zip_lo(x4_2, y5));
+          Vec::store(out + W, Vec::zip_hi(x4_2, y5));
+          std::copy(out, out + (len - n), dst + n);
+        }
+      }
+      y3_2 = y3;
+      x4_2 = x4;
+    }
+    y1_1 = y1;
+    x2_1 = x2;
+  }
+}
+
+//
+// Dispatch to the kernels above: a single signal with unit strides goes to the `_row`
+//    kernels with `RowVec`; other signals go to the `_fused` kernels, `Vec::W` lanes at a time,
+//    and the remaining lanes with the narrower vectors in `Rest...`, ending with `Scalar<T>`.
+//
+template <typename Vec, typename... Rest, typename T>
+SPERR_FORCE_INLINE void analysis_lanes(const T* src,
+                                       size_t src_stride,
+                                       T* low,
+                                       size_t low_stride,
+                                       T* high,
+                                       size_t high_stride,
+                                       size_t len,
+                                       size_t lanes,
+                                       const sperr::LiftingCoeffs<T>& c)
+{
+  size_t b = 0;
+  for (; b + Vec::W <= lanes; b += Vec::W)
+    analysis_fused<Vec>(src + b, src_stride, low + b, low_stride, high + b, high_stride, len, c);
+  if constexpr (sizeof...(Rest) > 0) {
+    if (b < lanes) {
+      analysis_lanes<Rest...>(src + b, src_stride, low + b, low_stride, high + b, high_stride,
+                              len, lanes - b, c);
+    }
+  }
+}
+
+template <typename Vec, typename... Rest, typename T>
+SPERR_FORCE_INLINE void synthesis_lanes(const T* low,
+                                        size_t low_stride,
+                                        const T* high,
+                                        size_t high_stride,
+                                        T* dst,
+                                        size_t dst_stride,
+                                        size_t len,
+                                        size_t lanes,
+                                        const sperr::LiftingCoeffs<T>& c)
+{
+  size_t b = 0;
+  for (; b + Vec::W <= lanes; b += Vec::W)
+    synthesis_fused<Vec>(low + b, low_stride, high + b, high_stride, dst + b, dst_stride, len, c);
+  if constexpr (sizeof...(Rest) > 0) {
+    if (b < lanes) {
+      synthesis_lanes<Rest...>(low + b, low_stride, high + b, high_stride, dst + b, dst_stride,
+                               len, lanes - b, c);
+    }
+  }
+}
+
+template <typename RowVec, typename... Vecs, typename T>
+SPERR_FORCE_INLINE void analysis_any(const T* src,
+                                     size_t src_stride,
+                                     T* low,
+                                     size_t low_stride,
+                                     T* high,
+                                     size_t high_stride,
+                                     size_t len,
+                                     size_t lanes,
+                                     const sperr::LiftingCoeffs<T>& c)
+{
+  if (lanes == 1 && src_stride == 1 && low_stride == 1 && high_stride == 1 &&
+      len >= 4 * RowVec::W)
+    analysis_row<RowVec>(src, low, high, len, c);
+  else
+    analysis_lanes<Vecs...>(src, src_stride, low, low_stride, high, high_stride, len, lanes, c);
+}
+
+template <typename RowVec, typename... Vecs, typename T>
+SPERR_FORCE_INLINE void synthesis_any(const T* low,
+                                      size_t low_stride,
+                                      const T* high,
+                                      size_t high_stride,
+                                      T* dst,
+                                      size_t dst_stride,
+                                      size_t len,
+                                      size_t lanes,
+                                      const sperr::LiftingCoeffs<T>& c)
+{
+  if (lanes == 1 && low_stride == 1 && high_stride == 1 && dst_stride == 1 &&
+      len >= 4 * RowVec::W)
+    synthesis_row<RowVec>(low, high, dst, len, c);
+  else
+    synthesis_lanes<Vecs...>(low, low_stride, high, high_stride, dst, dst_stride, len, lanes, c);
+}
+
+//
+// Scalar kernels. A single signal is processed one element at a time, as the shuffles needed by
+//    the `_row` kernels don't map well to plain loops.
+//
+template <typename T>
+using ArrayVec = Array<T, 16 / sizeof(T)>;
+
+template <typename T>
+void analysis_scalar(const T* src,
+                     size_t src_stride,
+                     T* low,
+                     size_t low_stride,
+                     T* high,
+                     size_t high_stride,
+                     size_t len,
+                     size_t lanes,
+                     const sperr::LiftingCoeffs<T>& c)
+{
+  analysis_lanes<ArrayVec<T>, Scalar<T>>(src, src_stride, low, low_stride, high, high_stride,
+                                         len, lanes, c);
+}
+
+template <typename T>
+void synthesis_scalar(const T* low,
+                      size_t low_stride,
+                      const T* high,
+                      size_t high_stride,
+                      T* dst,
+                      size_t dst_stride,
+                      size_t len,
+                      size_t lanes,
+                      const sperr::LiftingCoeffs<T>& c)
+{
+  synthesis_lanes<ArrayVec<T>, Scalar<T>>(low, low_stride, high, high_stride, dst, dst_stride,
+                                          len, lanes, c);
+}
+
+#ifdef USE_SIMD
+//
+// Vector operations for every instruction set and floating-point type.
+//
+#define SPERR_AVX2 __attribute__((target("avx2")))
+#define SPERR_AVX512 __attribute__((target("avx512f")))
+
+template <typename T>
+struct AVX2;
+
+template <>
+struct AVX2<double> {
+  using V = __m256d;
+  static constexpr size_t W = 4;
+  SPERR_AVX2 static V load(const double* p) { return _mm256_loadu_pd(p); }
+  SPERR_AVX2 static void store(double* p, V a) { _mm256_storeu_pd(p, a); }
+  SPERR_AVX2 static V set1(double c) { return _mm256_set1_pd(c); }
+  SPERR_AVX2 static V add(V a, V b) { return _mm256_add_pd(a, b); }
+  SPERR_AVX2 static V sub(V a, V b) { return _mm256_sub_pd(a, b); }
+  SPERR_AVX2 static V mul(V a, V b) { return _mm256_mul_pd(a, b); }
+  SPERR_AVX2 static V unzip_even(V a, V b)
+  {
+    return _mm256_permute4x64_pd(_mm256_unpacklo_pd(a, b), 0xD8);
+  }
+  SPERR_AVX2 static V unzip_odd(V a, V b)
+  {
+    return _mm256_permute4x64_pd(_mm256_unpackhi_pd(a, b), 0xD8);
+  }
+  SPERR_AVX2 static V zip_lo(V e, V o)
+  {
+    return _mm256_permute2f128_pd(_mm256_unpacklo_pd(e, o), _mm256_unpackhi_pd(e, o), 0x20);
+  }
+  SPERR_AVX2 static V zip_hi(V e, V o)
+  {
+    return _mm256_permute2f128_pd(_mm256_unpacklo_pd(e, o), _mm256_unpackhi_pd(e, o), 0x31);
+  }
+  SPERR_AVX2 static V succ(V a, V b)
+  {
+    const auto t = _mm256_castpd_si256(_mm256_permute2f128_pd(a, b, 0x21));
+    return _mm256_castsi256_pd(_mm256_alignr_epi8(t, _mm256_castpd_si256(a), 8));
+  }
+  SPERR_AVX2 static V pred(V a, V b)
+  {
+    const auto t = _mm256_castpd_si256(_mm256_permute2f128_pd(a, b, 0x21));
+    return _mm256_castsi256_pd(_mm256_alignr_epi8(_mm256_castpd_si256(b), t, 8));
+  }
+  SPERR_AVX2 static V bcast0(V a) { return _mm256_broadcastsd_pd(_mm256_castpd256_pd128(a)); }
+};
+
+template <>
+struct AVX2<float> {
+  using V = __m256;
+  static constexpr size_t W = 8;
+  SPERR_AVX2 static V load(const float* p) { return _mm256_loadu_ps(p); }
+  SPERR_AVX2 static void store(float* p, V a) { _mm256_storeu_ps(p, a); }
+  SPERR_AVX2 static V set1(float c) { return _mm256_set1_ps(c); }
+  SPERR_AVX2 static V add(V a, V b) { return _mm256_add_ps(a, b); }
+  SPERR_AVX2 static V sub(V a, V b) { return _mm256_sub_ps(a, b); }
+  SPERR_AVX2 static V mul(V a, V b) { return _mm256_mul_ps(a, b); }
+  SPERR_AVX2 static V unzip_even(V a, V b)
+  {
+    const auto t = _mm256_castps_pd(_mm256_shuffle_ps(a, b, 0x88));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(t, 0xD8));
+  }
+  SPERR_AVX2 static V unzip_odd(V a, V b)
+  {
+    const auto t = _mm256_castps_pd(_mm256_shuffle_ps(a, b, 0xDD));
+    return _mm256_castpd_ps(_mm256_permute4x64_pd(t, 0xD8));
+  }
+  SPERR_AVX2 static V zip_lo(V e, V o)
+  {
+    return _mm256_permute2f128_ps(_mm256_unpacklo_ps(e, o), _mm256_unpackhi_ps(e, o), 0x20);
+  }
+  SPERR_AVX2 static V zip_hi(V e, V o)
+  {
+    return _mm256_permute2f128_ps(_mm256_unpacklo_ps(e, o), _mm256_unpackhi_ps(e, o), 0x31);
+  }
+  SPERR_AVX2 static V succ(V a, V b)
+  {
+    const auto t = _mm256_castps_si256(_mm256_permute2f128_ps(a, b, 0x21));
+    return _mm256_castsi256_ps(_mm256_alignr_epi8(t, _mm256_castps_si256(a), 4));
+  }
+  SPERR_AVX2 static V pred(V a, V b)
+  {
+    const auto t = _mm256_castps_si256(_mm256_permute2f128_ps(a, b, 0x21));
+    return _mm256_castsi256_ps(_mm256_alignr_epi8(_mm256_castps_si256(b), t, 12));
+  }
+  SPERR_AVX2 static V bcast0(V a) { return _mm256_broadcastss_ps(_mm256_castps256_ps128(a)); }
+};
+
+template <typename T>
+struct AVX512;
+
+template <>
+struct AVX512<double> {
+  using V = __m512d;
+  static constexpr size_t W = 8;
+  SPERR_AVX512 static V load(const double* p) { return _mm512_loadu_pd(p); }
+  SPERR_AVX512 static void store(double* p, V a) { _mm512_storeu_pd(p, a); }
+  SPERR_AVX512 static V set1(double c) { return _mm512_set1_pd(c); }
+  SPERR_AVX512 static V add(V a, V b) { return _mm512_add_pd(a, b); }
+  SPERR_AVX512 static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+  SPERR_AVX512 static V mul(V a, V b) { return _mm512_mul_pd(a, b); }
+  SPERR_AVX512 static V unzip_even(V a, V b)
+  {
+    return _mm512_permutex2var_pd(a, _mm512_set_epi64(14, 12, 10, 8, 6, 4, 2, 0), b);
+  }
+  SPERR_AVX512 static V unzip_odd(V a, V b)
+  {
+    return _mm512_permutex2var_pd(a, _mm512_set_epi64(15, 13, 11, 9, 7, 5, 3, 1), b);
+  }
+  SPERR_AVX512 static V zip_lo(V e, V o)
+  {
+    return _mm512_permutex2var_pd(e, _mm512_set_epi64(11, 3, 10, 2, 9, 1, 8, 0), o);
+  }
+  SPERR_AVX512 static V zip_hi(V e, V o)
+  {
+    return _mm512_permutex2var_pd(e, _mm512_set_epi64(15, 7, 14, 6, 13, 5, 12, 4), o);
+  }
+  SPERR_AVX512 static V succ(V a, V b)
+  {
+    return _mm512_castsi512_pd(
+        _mm512_alignr_epi64(_mm512_castpd_si512(b), _mm512_castpd_si512(a), 1));
+  }
+  SPERR_AVX512 static V pred(V a, V b)
+  {
+    return _mm512_castsi512_pd(
+        _mm512_alignr_epi64(_mm512_castpd_si512(b), _mm512_castpd_si512(a), 7));
+  }
+  SPERR_AVX512 static V bcast0(V a) { return _mm512_broadcastsd_pd(_mm512_castpd512_pd128(a)); }
+};
+
+template <>
+struct AVX512<float> {
+  using V = __m512;
+  static constexpr size_t W = 16;
+  SPERR_AVX512 static V load(const float* p) { return _mm512_loadu_ps(p); }
+  SPERR_AVX512 static void store(float* p, V a) { _mm512_storeu_ps(p, a); }
+  SPERR_AVX512 static V set1(float c) { return _mm512_set1_ps(c); }
+  SPERR_AVX512 static V add(V a, V b) { return _mm512_add_ps(a, b); }
+  SPERR_AVX512 static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+  SPERR_AVX512 static V mul(V a, V b) { return _mm512_mul_ps(a, b); }
+  SPERR_AVX512 static V unzip_even(V a, V b)
+  {
+    const auto idx =
+        _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30);
+    return _mm512_permutex2var_ps(a, idx, b);
+  }
+  SPERR_AVX512 static V unzip_odd(V a, V b)
+  {
+    const auto idx =
+        _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31);
+    return _mm512_permutex2var_ps(a, idx, b);
+  }
+  SPERR_AVX512 static V zip_lo(V e, V o)
+  {
+    const auto idx = _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23);
+    return _mm512_permutex2var_ps(e, idx, o);
+  }
+  SPERR_AVX512 static V zip_hi(V e, V o)
+  {
+    const auto idx =
+        _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31);
+    return _mm512_permutex2var_ps(e, idx, o);
+  }
+  SPERR_AVX512 static V succ(V a, V b)
+  {
+    return _mm512_castsi512_ps(
+        _mm512_alignr_epi32(_mm512_castps_si512(b), _mm512_castps_si512(a), 1));
+  }
+  SPERR_AVX512 static V pred(V a, V b)
+  {
+    return _mm512_castsi512_ps(
+        _mm512_alignr_epi32(_mm512_castps_si512(b), _mm512_castps_si512(a), 15));
+  }
+  SPERR_AVX512 static V bcast0(V a) { return _mm512_broadcastss_ps(_mm512_castps512_ps128(a)); }
+};
+
+//
+// AVX2 kernels.
+//
+template <typename T>
+SPERR_AVX2 void analysis_avx2(const T* src,
+                              size_t src_stride,
+                              T* low,
+                              size_t low_stride,
+                              T* high,
+                              size_t high_stride,
+                              size_t len,
+                              size_t lanes,
+                              const sperr::LiftingCoeffs<T>& c)
+{
+  analysis_any<AVX2<T>, AVX2<T>, ArrayVec<T>, Scalar<T>>(src, src_stride, low, low_stride, high,
+                                                         high_stride, len, lanes, c);
+}
+
+template <typename T>
+SPERR_AVX2 void synthesis_avx2(const T* low,
+                               size_t low_stride,
+                               const T* high,
+                               size_t high_stride,
+                               T* dst,
+                               size_t dst_stride,
+                               size_t len,
+                               size_t lanes,
+                               const sperr::LiftingCoeffs<T>& c)
+{
+  synthesis_any<AVX2<T>, AVX2<T>, ArrayVec<T>, Scalar<T>>(low, low_stride, high, high_stride,
+                                                          dst, dst_stride, len, lanes, c);
+}
+
+//
+// AVX-512 kernels; the remaining lanes are processed with AVX2.
+//
+template <typename T>
+SPERR_AVX512 void analysis_avx512(const T* src,
+                                  size_t src_stride,
+                                  T* low,
+                                  size_t low_stride,
+                                  T* high,
+                                  size_t high_stride,
+                                  size_t len,
+                                  size_t lanes,
+                                  const sperr::LiftingCoeffs<T>& c)
+{
+  analysis_any<AVX512<T>, AVX512<T>, AVX2<T>, ArrayVec<T>, Scalar<T>>(
+      src, src_stride, low, low_stride, high, high_stride, len, lanes, c);
+}
+
+template <typename T>
+SPERR_AVX512 void synthesis_avx512(const T* low,
+                                   size_t low_stride,
+                                   const T* high,
+                                   size_t high_stride,
+                                   T* dst,
+                                   size_t dst_stride,
+                                   size_t len,
+                                   size_t lanes,
+                                   const sperr::LiftingCoeffs<T>& c)
+{
+  synthesis_any<AVX512<T>, AVX512<T>, AVX2<T>, ArrayVec<T>, Scalar<T>>(
+      low, low_stride, high, high_stride, dst, dst_stride, len, lanes, c);
+}
+
+#undef SPERR_AVX2
+#undef SPERR_AVX512
+#endif
+
+template <typename T>
+const auto scalar_kernels = sperr::LiftingKernels<T>{analysis_scalar<T>, synthesis_scalar<T>};
+#ifdef USE_SIMD
+template <typename T>
+const auto avx2_kernels = sperr::LiftingKernels<T>{analysis_avx2<T>, synthesis_avx2<T>};
+template <typename T>
+const auto avx512_kernels = sperr::LiftingKernels<T>{analysis_avx512<T>, synthesis_avx512<T>};
+#endif
+
+}  // namespace
+
+#undef SPERR_FORCE_INLINE
+
+template <typename T>
+auto sperr::lifting_kernels(ISAType isa) -> const LiftingKernels<T>&
+{
+  assert(sperr::isa_supported(isa));
+
+  switch (isa) {
+#ifdef USE_SIMD
+    case ISAType::AVX2:
+      return avx2_kernels<T>;
+    case ISAType::AVX512:
+      return avx512_kernels<T>;
+#endif
+    default:
+      return scalar_kernels<T>;
+  }
+}
+template auto sperr::lifting_kernels(ISAType) -> const LiftingKernels<float>&;
+template auto sperr::lifting_kernels(ISAType) -> const LiftingKernels<double>&;
@@ -0,0 +1,186 @@
+#include "CDF97_Stream.h"
+#include "CDF97_Kernels.h"
+
+#include <algorithm>
+#include <cassert>
+#include <type_traits>
+
+template <typename T>
+auto sperr::CDF97_Stream<T>::set_isa(ISAType isa) -> RTNType
+{
+  return m_cdf.set_isa(isa);
+}
+
+template <typename T>
+void sperr::CDF97_Stream<T>::set_num_threads(size_t n)
+{
+  m_cdf.set_num_threads(n);
+}
+
+template <typename T>
+void sperr::CDF97_Stream<T>::start(dims_type dims)
+{
+  m_dims = dims;
+  m_received = 0;
+  m_levels.clear();
+  m_slabs.clear();
+
+  // Dyadic decomposition transforms a shrinking top-left part of the planes at every level,
+  //    while wavelet packet decomposition transforms whole planes along Z.
+  const auto plan = sperr::make_dwt_plan(dims);
+  m_dyadic = plan->dyadic;
+  const auto num_levels = m_dyadic ? *m_dyadic : plan->xforms_z;
+  m_levels.resize(num_levels);
+  for (size_t lev = 0; lev < num_levels; lev++) {
+    const auto& approx = plan->approx[lev];
+    m_levels[lev].len = approx[2];
+    if (m_dyadic)
+      m_levels[lev].len_xy = {approx[0], approx[1]};
+    else
+      m_levels[lev].len_xy = {dims[0], dims[1]};
+  }
+}
+
+template <typename T>
+template <typename U>
+auto sperr::CDF97_Stream<T>::push(const U* planes, size_t num_planes) -> RTNType
+{
+  static_assert(std::is_floating_point<U>::value, "!! Only floating point values are supported !!");
+  if (m_received + num_planes > m_dims[2])
+    return RTNType::WrongLength;
+
+  const auto plane_size = m_dims[0] * m_dims[1];
+  for (size_t i = 0; i < num_planes; i++) {
+    const auto* src = planes + i * plane_size;
+    auto plane = vec_type<T>(src, src + plane_size);
+    if (m_levels.empty())
+      m_finish(m_received, {m_dims[0], m_dims[1]}, {0, 0}, std::move(plane));
+    else
+      m_feed(0, std::move(plane));
+    m_received++;
+  }
+
+  return RTNType::Good;
+}
+
+template <typename T>
+auto sperr::CDF97_Stream<T>::release_slabs() -> std::vector<Slab>
+{
+  auto slabs = std::vector<Slab>();
+  std::swap(slabs, m_slabs);
+  return slabs;
+}
+
+template <typename T>
+auto sperr::CDF97_Stream<T>::finished() const -> bool
+{
+  return m_dims[2] > 0 && m_received == m_dims[2];
+}
+
+template <typename T>
+void sperr::CDF97_Stream<T>::m_feed(size_t lev, vec_type<T>&& plane)
+{
+  auto& level = m_levels[lev];
+
+  // Dyadic decomposition transforms XY planes before Z columns at every level.
+  if (m_dyadic) {
+    m_cdf.take_data(std::move(plane), {level.len_xy[0], level.len_xy[1], 1});
+    m_cdf.m_dwt2d_one_level(m_cdf.m_data_buf.begin(), level.len_xy);
+    plane = m_cdf.release_data();
+  }
+  level.planes.emplace_back(std::move(plane));
+  level.received++;
+
+  // Produce batches of Z coefficients once all the planes that they need are available.
+  const auto num_pairs = level.len - level.len / 2;
+  while (level.next < num_pairs) {
+    const auto k1 = std::min(level.next + BATCH, num_pairs);
+    if (level.received < std::min(k1 * 2 + RADIUS, level.len))
+      break;
+    m_produce(lev, level.next, k1);
+  }
+}
+
+template <typename T>
+void sperr::CDF97_Stream<T>::m_produce(size_t lev, size_t k0, size_t k1)
+{
+  auto& level = m_levels[lev];
+  const auto lanes = level.len_xy[0] * level.len_xy[1];
+  const auto low_len = level.len - level.len / 2;
+
+  // Transform a window of planes that reaches `RADIUS` beyond the coefficients to produce, so
+  //    that they aren't affected by the artificial boundaries of the window.
+  const auto beg = k0 * 2 > RADIUS ? k0 * 2 - RADIUS : 0;
+  const auto end = std::min(k1 * 2 + RADIUS, level.len);
+  const auto len = end - beg;
+  level.window.resize(len * lanes);
+  level.low.resize((len - len / 2) * lanes);
+  level.high.resize(len / 2 * lanes);
+  for (size_t z = beg; z < end; z++) {
+    const auto& p = level.planes[z - level.first];
+    assert(p.size() == lanes);
+    std::copy(p.cbegin(), p.cend(), level.window.begin() + (z - beg) * lanes);
+  }
+
+  const auto& k = sperr::lifting_kernels<T>(m_cdf.m_isa);
+  const auto coeffs = LiftingCoeffs<T>{m_cdf.ALPHA,   m_cdf.BETA,    m_cdf.GAMMA,
+                                       m_cdf.DELTA,   m_cdf.EPSILON, m_cdf.INV_EPSILON};
+  k.analysis(level.window.data(), lanes, level.low.data(), lanes, level.high.data(), lanes, len,
+             lanes, coeffs);
+
+  // Planes below the next window are no longer needed.
+  const auto keep = k1 * 2 > RADIUS ? k1 * 2 - RADIUS : 0;
+  while (level.first < keep) {
+    level.planes.pop_front();
+    level.first++;
+  }
+  level.next = k1;
+
+  for (size_t i = k0; i < k1; i++) {
+    const auto low = level.low.cbegin() + (i - beg / 2) * lanes;
+    auto low_plane = vec_type<T>(low, low + lanes);
+    if (i < level.len / 2) {
+      const auto high = level.high.cbegin() + (i - beg / 2) * lanes;
+      m_finish(low_len + i, level.len_xy, {0, 0}, vec_type<T>(high, high + lanes));
+    }
+
+    if (lev + 1 == m_levels.size())
+      m_finish(i, level.len_xy, {0, 0}, std::move(low_plane));
+    else if (m_dyadic) {
+      // The top-left part of a low pass plane goes on to the next level, and the rest of it
+      //    is finished.
+      const auto next_xy = m_levels[lev + 1].len_xy;
+      auto next_plane = vec_type<T>(next_xy[0] * next_xy[1]);
+      for (size_t y = 0; y < next_xy[1]; y++) {
+        const auto row = low_plane.cbegin() + y * level.len_xy[0];
+        std::copy(row, row + next_xy[0], next_plane.begin() + y * next_xy[0]);
+      }
+      m_finish(i, level.len_xy, next_xy, std::move(low_plane));
+      m_feed(lev + 1, std::move(next_plane));
+    }
+    else
+      m_feed(lev + 1, std::move(low_plane));
+  }
+}
+
+template <typename T>
+void sperr::CDF97_Stream<T>::m_finish(size_t z,
+                                      std::array<size_t, 2> len_xy,
+                                      std::array<size_t, 2> hole_xy,
+                                      vec_type<T>&& plane)
+{
+  if (!m_dyadic) {
+    m_cdf.take_data(std::move(plane), {len_xy[0], len_xy[1], 1});
+    m_cdf.dwt2d();
+    plane = m_cdf.release_data();
+  }
+  m_slabs.push_back({z, len_xy, hole_xy, std::move(plane)});
+}
+
+template class sperr::CDF97_Stream<float>;
+template class sperr::CDF97_Stream<double>;
+
+template auto sperr::CDF97_Stream<float>::push(const float*, size_t) -> RTNType;
+template auto sperr::CDF97_Stream<float>::push(const double*, size_t) -> RTNType;
+template auto sperr::CDF97_Stream<double>::push(const float*, size_t) -> RTNType;
+template auto sperr::CDF97_Stream<double>::push(const double*, size_t) -> RTNType;
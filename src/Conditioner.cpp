@@ -15,7 +15,7 @@ auto sperr::Conditioner::condition(vecd_type& buf, dims_type dims) -> condi_type
 
   assert(!buf.empty());
   auto meta = std::array<bool, 8>{true,    // subtract mean
-                                  false,   // unused
+                                  false,   // [1]: code blocks? Set by `mark_code_blocks()`.
                                   false,   // unused
                                   false,   // unused
                                   false,   // unused
@@ -101,6 +101,19 @@ auto sperr::Conditioner::is_constant(uint8_t byte) const -> bool
   return b8[m_constant_field_idx];
 }
 
+void sperr::Conditioner::mark_code_blocks(condi_type& header, bool flag) const
+{
+  auto b8 = sperr::unpack_8_booleans(header[0]);
+  b8[m_code_blocks_idx] = flag;
+  header[0] = sperr::pack_8_booleans(b8);
+}
+
+auto sperr::Conditioner::has_code_blocks(uint8_t byte) const -> bool
+{
+  auto b8 = sperr::unpack_8_booleans(byte);
+  return b8[m_code_blocks_idx];
+}
+
 void sperr::Conditioner::save_q(condi_type& header, double q) const
 {
   // Save at position 9, the same as in `retrieve_q()`.
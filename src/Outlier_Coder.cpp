@@ -39,6 +39,11 @@ void sperr::Outlier_Coder::append_encoded_bitstream(vec8_type& buf) const
   std::visit([&buf](auto&& enc) { enc.append_encoded_bitstream(buf); }, m_encoder);
 }
 
+auto sperr::Outlier_Coder::encoded_bitstream_len() const -> size_t
+{
+  return std::visit([](auto&& enc) { return enc.encoded_bitstream_len(); }, m_encoder);
+}
+
 auto sperr::Outlier_Coder::get_stream_full_len(const void* p) const -> size_t
 {
   return std::visit([p](auto&& dec) { return dec.get_stream_full_len(p); }, m_decoder);
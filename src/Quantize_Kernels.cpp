@@ -0,0 +1,385 @@
+#include "Quantize_Kernels.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <type_traits>
+
+#ifdef USE_SIMD
+// GCC 12 leaves the unused part of many AVX-512 intrinsics (`__Y` in avx512fintrin.h)
+//    undefined on purpose, and then warns about it wherever they're inlined. The warnings
+//    are only silenced within the intrinsic headers themselves. This pragma doesn't survive
+//    link-time optimization, so this file is built without it (see src/CMakeLists.txt).
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#include <immintrin.h>
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif
+
+namespace {
+
+//
+// Scalar kernels, which also process the values that don't fill up a 64-bit sign word in the
+//    SIMD kernels.
+//
+auto max_magnitude_scalar(const double* vals, size_t len) -> double
+{
+  auto max = 0.0;
+  for (size_t i = 0; i < len; i++)
+    max = std::max(max, std::abs(vals[i]));
+  return max;
+}
+
+template <typename T>
+void quantize_range(const double* vals,
+                    size_t begin,
+                    size_t end,
+                    double inv_q,
+                    T* ints,
+                    sperr::Bitmask& signs)
+{
+  for (size_t i = begin; i < end; i++) {
+    const auto ll = std::llrint(vals[i] * inv_q);
+    signs.wbit(i, ll >= 0);
+    ints[i] = static_cast<T>(std::abs(ll));
+  }
+}
+
+template <typename T>
+void quantize_scalar(const double* vals, size_t len, double inv_q, T* ints, sperr::Bitmask& signs)
+{
+  const auto len_x64 = len - len % 64;
+
+  // Process 64 values at a time.
+  for (size_t i = 0; i < len_x64; i += 64) {
+    auto bits64 = uint64_t{0};
+    for (size_t j = 0; j < 64; j++) {
+      const auto ll = std::llrint(vals[i + j] * inv_q);
+      bits64 |= uint64_t{ll >= 0} << j;
+      ints[i + j] = static_cast<T>(std::abs(ll));
+    }
+    signs.wlong(i, bits64);
+  }
+
+  quantize_range(vals, len_x64, len, inv_q, ints, signs);
+}
+
+template <typename T>
+void inv_quantize_range(const T* ints,
+                        const sperr::Bitmask& signs,
+                        size_t begin,
+                        size_t end,
+                        double q,
+                        double* vals)
+{
+  const auto tmpd = std::array<double, 2>{-1.0, 1.0};
+  for (size_t i = begin; i < end; i++)
+    vals[i] = q * static_cast<double>(ints[i]) * tmpd[signs.rbit(i)];
+}
+
+template <typename T>
+void inv_quantize_scalar(const T* ints,
+                         const sperr::Bitmask& signs,
+                         size_t len,
+                         double q,
+                         double* vals)
+{
+  const auto tmpd = std::array<double, 2>{-1.0, 1.0};
+  const auto len_x64 = len - len % 64;
+
+  // Process 64 values at a time.
+  for (size_t i = 0; i < len_x64; i += 64) {
+    const auto bits64 = signs.rlong(i);
+    for (size_t j = 0; j < 64; j++) {
+      const auto bit = (bits64 >> j) & uint64_t{1};
+      vals[i + j] = q * static_cast<double>(ints[i + j]) * tmpd[bit];
+    }
+  }
+
+  inv_quantize_range(ints, signs, len_x64, len, q, vals);
+}
+
+#ifdef USE_SIMD
+//
+// SIMD kernels, on integers of up to 32 bits.
+//    Every value is rounded as a double (to nearest, ties to even), so the sign is that of the
+//    rounded value (-0.0 counts as non-negative, same as `std::llrint()` returning 0), and the
+//    magnitude is exact before it's converted to an integer. The signs of 64 values are
+//    gathered from vector compare masks into one word, and written by `Bitmask::wlong()`.
+//
+#define SPERR_AVX2 __attribute__((target("avx2")))
+#define SPERR_AVX512 __attribute__((target("avx512f")))
+
+SPERR_AVX2 auto max_magnitude_avx2(const double* vals, size_t len) -> double
+{
+  const auto abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffff));
+  const auto len_x8 = len - len % 8;
+  auto max0 = _mm256_setzero_pd(), max1 = max0;
+  for (size_t i = 0; i < len_x8; i += 8) {
+    max0 = _mm256_max_pd(max0, _mm256_and_pd(abs_mask, _mm256_loadu_pd(vals + i)));
+    max1 = _mm256_max_pd(max1, _mm256_and_pd(abs_mask, _mm256_loadu_pd(vals + i + 4)));
+  }
+  auto buf = std::array<double, 4>();
+  _mm256_storeu_pd(buf.data(), _mm256_max_pd(max0, max1));
+  const auto max = *std::max_element(buf.cbegin(), buf.cend());
+  return std::max(max, max_magnitude_scalar(vals + len_x8, len - len_x8));
+}
+
+// Clear the sign bits, which is what `_mm512_abs_pd()` does too.
+SPERR_AVX512 inline auto abs_avx512(__m512d x) -> __m512d
+{
+  const auto sign_bits = _mm512_set1_epi64(std::numeric_limits<int64_t>::min());
+  return _mm512_castsi512_pd(_mm512_andnot_epi64(sign_bits, _mm512_castpd_si512(x)));
+}
+
+SPERR_AVX512 auto max_magnitude_avx512(const double* vals, size_t len) -> double
+{
+  const auto len_x16 = len - len % 16;
+  auto max0 = _mm512_setzero_pd(), max1 = max0;
+  for (size_t i = 0; i < len_x16; i += 16) {
+    max0 = _mm512_max_pd(max0, abs_avx512(_mm512_loadu_pd(vals + i)));
+    max1 = _mm512_max_pd(max1, abs_avx512(_mm512_loadu_pd(vals + i + 8)));
+  }
+  auto buf = std::array<double, 8>();
+  _mm512_storeu_pd(buf.data(), _mm512_max_pd(max0, max1));
+  const auto max = *std::max_element(buf.cbegin(), buf.cend());
+  return std::max(max, max_magnitude_scalar(vals + len_x16, len - len_x16));
+}
+
+template <typename T>
+SPERR_AVX2 void quantize_avx2(const double* vals,
+                              size_t len,
+                              double inv_q,
+                              T* ints,
+                              sperr::Bitmask& signs)
+{
+  static_assert(sizeof(T) <= sizeof(uint32_t));
+  const auto vinv = _mm256_set1_pd(inv_q);
+  const auto zero = _mm256_setzero_pd();
+  const auto abs_mask = _mm256_castsi256_pd(_mm256_set1_epi64x(0x7fffffffffffffff));
+  const auto magic = _mm256_set1_pd(0x1p52);
+  const auto low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+  const auto len_x64 = len - len % 64;
+
+  for (size_t i = 0; i < len_x64; i += 64) {
+    auto bits64 = uint64_t{0};
+    for (size_t j = 0; j < 64; j += 16) {
+      __m128i u[4];
+      for (size_t k = 0; k < 4; k++) {
+        const auto x = _mm256_mul_pd(_mm256_loadu_pd(vals + i + j + k * 4), vinv);
+        const auto r = _mm256_round_pd(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+        const auto nonneg = _mm256_movemask_pd(_mm256_cmp_pd(r, zero, _CMP_GE_OQ));
+        bits64 |= uint64_t(nonneg) << (j + k * 4);
+
+        // Adding 2^52 to a magnitude (< 2^52) puts it in the low mantissa bits of the sum.
+        const auto m = _mm256_add_pd(_mm256_and_pd(r, abs_mask), magic);
+        const auto m32 = _mm256_permutevar8x32_epi32(_mm256_castpd_si256(m), low_halves);
+        u[k] = _mm256_castsi256_si128(m32);
+      }
+
+      auto* p = reinterpret_cast<__m128i*>(ints + i + j);
+      if constexpr (std::is_same_v<T, uint32_t>) {
+        for (size_t k = 0; k < 4; k++)
+          _mm_storeu_si128(p + k, u[k]);
+      }
+      else if constexpr (std::is_same_v<T, uint16_t>) {
+        _mm_storeu_si128(p, _mm_packus_epi32(u[0], u[1]));
+        _mm_storeu_si128(p + 1, _mm_packus_epi32(u[2], u[3]));
+      }
+      else {
+        const auto lo = _mm_packus_epi32(u[0], u[1]), hi = _mm_packus_epi32(u[2], u[3]);
+        _mm_storeu_si128(p, _mm_packus_epi16(lo, hi));
+      }
+    }
+    signs.wlong(i, bits64);
+  }
+
+  quantize_range(vals, len_x64, len, inv_q, ints, signs);
+}
+
+template <typename T>
+SPERR_AVX2 void inv_quantize_avx2(const T* ints,
+                                  const sperr::Bitmask& signs,
+                                  size_t len,
+                                  double q,
+                                  double* vals)
+{
+  static_assert(sizeof(T) <= sizeof(uint32_t));
+  const auto vq = _mm256_set1_pd(q);
+  const auto magic_bits = _mm256_castpd_si256(_mm256_set1_pd(0x1p52));
+  const auto magic = _mm256_set1_pd(0x1p52);
+  const auto neg_zero = _mm256_set1_pd(-0.0);
+  const auto lane_bits = _mm256_setr_epi64x(1, 2, 4, 8);
+  const auto len_x64 = len - len % 64;
+
+  for (size_t i = 0; i < len_x64; i += 64) {
+    const auto bits64 = signs.rlong(i);
+    for (size_t j = 0; j < 64; j += 4) {
+      const T* const p = ints + i + j;
+      auto u = __m128i();
+      if constexpr (std::is_same_v<T, uint32_t>)
+        u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+      else if constexpr (std::is_same_v<T, uint16_t>)
+        u = _mm_cvtepu16_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(p)));
+      else {
+        auto four = int32_t{0};
+        std::memcpy(&four, p, sizeof(four));
+        u = _mm_cvtepu8_epi32(_mm_cvtsi32_si128(four));
+      }
+
+      // An integer (< 2^52) in the low mantissa bits of 2^52 makes 2^52 plus that integer.
+      const auto m = _mm256_or_si256(_mm256_cvtepu32_epi64(u), magic_bits);
+      const auto prod = _mm256_mul_pd(vq, _mm256_sub_pd(_mm256_castsi256_pd(m), magic));
+
+      // Flip the sign of values whose sign bits are 0.
+      const auto bits = _mm256_set1_epi64x(int64_t(bits64 >> j));
+      const auto pos = _mm256_cmpeq_epi64(_mm256_and_si256(bits, lane_bits), lane_bits);
+      const auto flip = _mm256_andnot_pd(_mm256_castsi256_pd(pos), neg_zero);
+      _mm256_storeu_pd(vals + i + j, _mm256_xor_pd(prod, flip));
+    }
+  }
+
+  inv_quantize_range(ints, signs, len_x64, len, q, vals);
+}
+
+template <typename T>
+SPERR_AVX512 void quantize_avx512(const double* vals,
+                                  size_t len,
+                                  double inv_q,
+                                  T* ints,
+                                  sperr::Bitmask& signs)
+{
+  static_assert(sizeof(T) <= sizeof(uint32_t));
+  const auto vinv = _mm512_set1_pd(inv_q);
+  const auto zero = _mm512_setzero_pd();
+  const auto len_x64 = len - len % 64;
+
+  for (size_t i = 0; i < len_x64; i += 64) {
+    auto bits64 = uint64_t{0};
+    for (size_t j = 0; j < 64; j += 16) {
+      const auto x0 = _mm512_mul_pd(_mm512_loadu_pd(vals + i + j), vinv);
+      const auto x1 = _mm512_mul_pd(_mm512_loadu_pd(vals + i + j + 8), vinv);
+      const auto r0 = _mm512_roundscale_pd(x0, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      const auto r1 = _mm512_roundscale_pd(x1, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+      bits64 |= uint64_t(_mm512_cmp_pd_mask(r0, zero, _CMP_GE_OQ)) << j;
+      bits64 |= uint64_t(_mm512_cmp_pd_mask(r1, zero, _CMP_GE_OQ)) << (j + 8);
+
+      const auto u0 = _mm512_cvtpd_epu32(abs_avx512(r0));
+      const auto u1 = _mm512_cvtpd_epu32(abs_avx512(r1));
+      const auto u = _mm512_inserti64x4(_mm512_castsi256_si512(u0), u1, 1);
+      void* const p = ints + i + j;
+      if constexpr (std::is_same_v<T, uint32_t>)
+        _mm512_storeu_si512(p, u);
+      else if constexpr (std::is_same_v<T, uint16_t>)
+        _mm256_storeu_si256(static_cast<__m256i*>(p), _mm512_cvtepi32_epi16(u));
+      else
+        _mm_storeu_si128(static_cast<__m128i*>(p), _mm512_cvtepi32_epi8(u));
+    }
+    signs.wlong(i, bits64);
+  }
+
+  quantize_range(vals, len_x64, len, inv_q, ints, signs);
+}
+
+template <typename T>
+SPERR_AVX512 void inv_quantize_avx512(const T* ints,
+                                      const sperr::Bitmask& signs,
+                                      size_t len,
+                                      double q,
+                                      double* vals)
+{
+  static_assert(sizeof(T) <= sizeof(uint32_t));
+  const auto vq = _mm512_set1_pd(q);
+  const auto sign_bits = _mm512_set1_epi64(std::numeric_limits<int64_t>::min());
+  const auto len_x64 = len - len % 64;
+
+  for (size_t i = 0; i < len_x64; i += 64) {
+    const auto bits64 = signs.rlong(i);
+    for (size_t j = 0; j < 64; j += 16) {
+      const void* const p = ints + i + j;
+      auto u = __m512i();
+      if constexpr (std::is_same_v<T, uint32_t>)
+        u = _mm512_loadu_si512(p);
+      else if constexpr (std::is_same_v<T, uint16_t>)
+        u = _mm512_cvtepu16_epi32(_mm256_loadu_si256(static_cast<const __m256i*>(p)));
+      else
+        u = _mm512_cvtepu8_epi32(_mm_loadu_si128(static_cast<const __m128i*>(p)));
+
+      const auto prod0 = _mm512_mul_pd(vq, _mm512_cvtepu32_pd(_mm512_castsi512_si256(u)));
+      const auto prod1 = _mm512_mul_pd(vq, _mm512_cvtepu32_pd(_mm512_extracti64x4_epi64(u, 1)));
+
+      // Flip the sign of values whose sign bits are 0.
+      const auto neg0 = static_cast<__mmask8>(~(bits64 >> j));
+      const auto neg1 = static_cast<__mmask8>(~(bits64 >> (j + 8)));
+      const auto int0 = _mm512_castpd_si512(prod0), int1 = _mm512_castpd_si512(prod1);
+      const auto res0 = _mm512_mask_xor_epi64(int0, neg0, int0, sign_bits);
+      const auto res1 = _mm512_mask_xor_epi64(int1, neg1, int1, sign_bits);
+      _mm512_storeu_pd(vals + i + j, _mm512_castsi512_pd(res0));
+      _mm512_storeu_pd(vals + i + j + 8, _mm512_castsi512_pd(res1));
+    }
+  }
+
+  inv_quantize_range(ints, signs, len_x64, len, q, vals);
+}
+
+#undef SPERR_AVX2
+#undef SPERR_AVX512
+#endif
+
+template <typename T>
+const auto scalar_kernels = sperr::QuantizeKernels<T>{quantize_scalar<T>, inv_quantize_scalar<T>};
+#ifdef USE_SIMD
+template <typename T>
+const auto avx2_kernels = sperr::QuantizeKernels<T>{quantize_avx2<T>, inv_quantize_avx2<T>};
+template <typename T>
+const auto avx512_kernels = sperr::QuantizeKernels<T>{quantize_avx512<T>, inv_quantize_avx512<T>};
+#endif
+
+}  // namespace
+
+template <typename T>
+auto sperr::quantize_kernels(ISAType isa) -> const QuantizeKernels<T>&
+{
+  assert(sperr::isa_supported(isa));
+
+#ifdef USE_SIMD
+  if constexpr (sizeof(T) <= sizeof(uint32_t)) {
+    switch (isa) {
+      case ISAType::AVX2:
+        return avx2_kernels<T>;
+      case ISAType::AVX512:
+        return avx512_kernels<T>;
+      default:;
+    }
+  }
+#endif
+  return scalar_kernels<T>;
+}
+template auto sperr::quantize_kernels(ISAType) -> const QuantizeKernels<uint8_t>&;
+template auto sperr::quantize_kernels(ISAType) -> const QuantizeKernels<uint16_t>&;
+template auto sperr::quantize_kernels(ISAType) -> const QuantizeKernels<uint32_t>&;
+template auto sperr::quantize_kernels(ISAType) -> const QuantizeKernels<uint64_t>&;
+
+auto sperr::max_magnitude(const double* vals, size_t len, ISAType isa) -> double
+{
+  assert(sperr::isa_supported(isa));
+
+  switch (isa) {
+#ifdef USE_SIMD
+    case ISAType::AVX2:
+      return max_magnitude_avx2(vals, len);
+    case ISAType::AVX512:
+      return max_magnitude_avx512(vals, len);
+#endif
+    default:
+      return max_magnitude_scalar(vals, len);
+  }
+}
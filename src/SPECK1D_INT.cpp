@@ -31,6 +31,8 @@ void sperr::SPECK1D_INT<T>::m_initialize_lists()
   auto sets = m_partition_set(set);
   m_LIS[sets[0].get_level()].emplace_back(sets[0]);
   m_LIS[sets[1].get_level()].emplace_back(sets[1]);
+
+  m_additional_initialization();
 }
 
 template <typename T>
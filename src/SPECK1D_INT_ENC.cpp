@@ -160,22 +160,73 @@ void sperr::SPECK1D_INT_ENC<T>::m_code_S(size_t idx1,
   }
 }
 
+template <typename T>
+void sperr::SPECK1D_INT_ENC<T>::m_additional_initialization()
+{
+  // For the encoder, this function builds the hierarchy of block maximums, until the top level
+  //    has no more than `BLOCK` values.
+  //
+  auto num_lev = size_t{0};
+  for (auto len = m_coeff_buf.size(); len > BLOCK; len = (len + BLOCK - 1) / BLOCK)
+    num_lev++;
+  m_block_max.resize(num_lev);
+
+  const auto max = [](auto a, auto b) { return std::max(a, b); };
+  for (size_t lev = 0; lev < num_lev; lev++) {
+    const auto& vals = lev == 0 ? m_coeff_buf : m_block_max[lev - 1];
+    auto& block_max = m_block_max[lev];
+    block_max.resize((vals.size() + BLOCK - 1) / BLOCK);
+    for (size_t i = 0; i < block_max.size(); i++) {
+      auto first = vals.cbegin() + i * BLOCK;
+      auto last = vals.cbegin() + std::min((i + 1) * BLOCK, vals.size());
+      block_max[i] = std::accumulate(first, last, uint_type{0}, max);
+    }
+  }
+}
+
 template <typename T>
 auto sperr::SPECK1D_INT_ENC<T>::m_decide_significance(const Set1D& set) const
     -> std::optional<size_t>
 {
   assert(set.get_length() != 0);
 
-  const auto gtr = [thld = m_threshold](auto v) { return v >= thld; };
-  auto first = m_coeff_buf.cbegin() + set.get_start();
-  auto last = first + set.get_length();
-  auto found = std::find_if(first, last, gtr);
-  if (found != last)
-    return static_cast<size_t>(std::distance(first, found));
+  const auto start = set.get_start();
+  auto found = m_find_significant(0, start, start + set.get_length());
+  if (found)
+    return *found - start;
   else
     return {};
 }
 
+template <typename T>
+auto sperr::SPECK1D_INT_ENC<T>::m_find_significant(size_t lev, size_t lo, size_t hi) const
+    -> std::optional<size_t>
+{
+  const auto& vals = lev == 0 ? m_coeff_buf : m_block_max[lev - 1];
+  const auto gtr = [thld = m_threshold](auto v) { return v >= thld; };
+  const auto find = [&vals, gtr](size_t first, size_t last) -> std::optional<size_t> {
+    auto it = std::find_if(vals.cbegin() + first, vals.cbegin() + last, gtr);
+    if (it != vals.cbegin() + last)
+      return static_cast<size_t>(std::distance(vals.cbegin(), it));
+    else
+      return {};
+  };
+
+  // Short ranges, or ranges at the top level, are scanned directly.
+  const auto block_lo = (lo + BLOCK - 1) / BLOCK;
+  const auto block_hi = hi / BLOCK;
+  if (lev == m_block_max.size() || block_lo >= block_hi)
+    return find(lo, hi);
+
+  // Otherwise, the range is a partial block at its head, whole blocks that are decided by the
+  //    next level up, and a partial block at its tail.
+  if (auto head = find(lo, block_lo * BLOCK))
+    return head;
+  if (auto block = m_find_significant(lev + 1, block_lo, block_hi))
+    return find(*block * BLOCK, *block * BLOCK + BLOCK);
+  return find(block_hi * BLOCK, hi);
+}
+
 template class sperr::SPECK1D_INT_ENC<uint64_t>;
 template class sperr::SPECK1D_INT_ENC<uint32_t>;
 template class sperr::SPECK1D_INT_ENC<uint16_t>;
@@ -2,45 +2,45 @@
 #include "SPECK3D_INT_DEC.h"
 #include "SPECK3D_INT_ENC.h"
 
-void sperr::SPECK3D_FLT::m_instantiate_encoder()
+void sperr::SPECK3D_FLT::m_instantiate_encoder(speck_int_ptr& encoder)
 {
   switch (m_uint_flag) {
     case UINTType::UINT8:
-      if (m_encoder.index() != 0 || std::get<0>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint8_t>>();
+      if (encoder.index() != 0 || std::get<0>(encoder) == nullptr)
+        encoder = std::make_unique<SPECK3D_INT_ENC<uint8_t>>();
       break;
     case UINTType::UINT16:
-      if (m_encoder.index() != 1 || std::get<1>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint16_t>>();
+      if (encoder.index() != 1 || std::get<1>(encoder) == nullptr)
+        encoder = std::make_unique<SPECK3D_INT_ENC<uint16_t>>();
       break;
     case UINTType::UINT32:
-      if (m_encoder.index() != 2 || std::get<2>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint32_t>>();
+      if (encoder.index() != 2 || std::get<2>(encoder) == nullptr)
+        encoder = std::make_unique<SPECK3D_INT_ENC<uint32_t>>();
       break;
     default:
-      if (m_encoder.index() != 3 || std::get<3>(m_encoder) == nullptr)
-        m_encoder = std::make_unique<SPECK3D_INT_ENC<uint64_t>>();
+      if (encoder.index() != 3 || std::get<3>(encoder) == nullptr)
+        encoder = std::make_unique<SPECK3D_INT_ENC<uint64_t>>();
   }
 }
 
-void sperr::SPECK3D_FLT::m_instantiate_decoder()
+void sperr::SPECK3D_FLT::m_instantiate_decoder(speck_int_ptr& decoder)
 {
   switch (m_uint_flag) {
     case UINTType::UINT8:
-      if (m_decoder.index() != 0 || std::get<0>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint8_t>>();
+      if (decoder.index() != 0 || std::get<0>(decoder) == nullptr)
+        decoder = std::make_unique<SPECK3D_INT_DEC<uint8_t>>();
       break;
     case UINTType::UINT16:
-      if (m_decoder.index() != 1 || std::get<1>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint16_t>>();
+      if (decoder.index() != 1 || std::get<1>(decoder) == nullptr)
+        decoder = std::make_unique<SPECK3D_INT_DEC<uint16_t>>();
       break;
     case UINTType::UINT32:
-      if (m_decoder.index() != 2 || std::get<2>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint32_t>>();
+      if (decoder.index() != 2 || std::get<2>(decoder) == nullptr)
+        decoder = std::make_unique<SPECK3D_INT_DEC<uint32_t>>();
       break;
     default:
-      if (m_decoder.index() != 3 || std::get<3>(m_decoder) == nullptr)
-        m_decoder = std::make_unique<SPECK3D_INT_DEC<uint64_t>>();
+      if (decoder.index() != 3 || std::get<3>(decoder) == nullptr)
+        decoder = std::make_unique<SPECK3D_INT_DEC<uint64_t>>();
   }
 }
 
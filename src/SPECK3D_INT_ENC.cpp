@@ -6,156 +6,145 @@
 #include <numeric>
 
 template <typename T>
-void sperr::SPECK3D_INT_ENC<T>::m_deposit_set(Set3D set)
+void sperr::SPECK3D_INT_ENC<T>::m_list_blocks(Set3D set)
 {
-  switch (set.num_elem()) {
-    case 0:
-      return;
-    case 1: {
-      auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-      m_morton_buf[set.get_morton()] = m_coeff_buf[id];
-      return;
-    }
-    case 2: {
-      // We directly deposit the 2 elements in `set` instead of performing another partition.
-      //
-      // Deposit the 1st element.
-      auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-      auto morton_id = set.get_morton();
-      m_morton_buf[morton_id] = m_coeff_buf[id];
-
-      // Deposit the 2nd element.
-      if (set.length_x == 2)
-        id++;
-      else if (set.length_y == 2)
-        id += m_dims[0];
-      else
-        id += m_dims[0] * m_dims[1];
-      m_morton_buf[++morton_id] = m_coeff_buf[id];
-
-      return;
-    }
-    case 4: {
-      const auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-      auto morton_id = set.get_morton();
-
-      if (set.length_x == 2 && set.length_y == 2) {
-        // Element (0, 0, 0)
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (1, 0, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[id + 1];
-
-        // Element (0, 1, 0)
-        auto id2 = id + m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 1, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        return;
-      }
-      else if (set.length_x == 2 && set.length_z == 2) {
-        // Element (0, 0, 0)
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (1, 0, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[id + 1];
-
-        // Element (0, 0, 1)
-        auto id2 = id + m_dims[0] * m_dims[1];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 0, 1)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        return;
-      }
-      else if (set.length_y == 2 && set.length_z == 2) {
-        // Element (0, 0, 0)
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (0, 1, 0)
-        auto id2 = id + m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (0, 0, 1)
-        id2 = id + m_dims[0] * m_dims[1];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (0, 1, 1)
-        id2 += m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        return;
-      }
-      else
-        break;  // Fall back to the recursive case.
-    }
-    case 8: {
-      if (set.length_x == 2 && set.length_y == 2) {
-        // Element (0, 0, 0)
-        const auto id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
-        auto morton_id = set.get_morton();
-        m_morton_buf[morton_id] = m_coeff_buf[id];
-
-        // Element (1, 0, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[id + 1];
-
-        // Element (0, 1, 0)
-        auto id2 = id + m_dims[0];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
-
-        // Element (1, 1, 0)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
-
-        // Element (0, 0, 1)
-        id2 = id + m_dims[0] * m_dims[1];
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
+  // A set of 1 or 2 elements, of 2x2 elements on any plane, or of 2x2x2 elements is a block.
+  //    Other sets are partitioned further, in the same way as when coding them.
+  const auto num_elem = set.num_elem();
+  if (num_elem == 0)
+    return;
+
+  const auto axes = uint64_t{set.length_x == 2} | uint64_t{set.length_y == 2} << 1 |
+                    uint64_t{set.length_z == 2} << 2;
+  if (num_elem <= 2 || (num_elem == 4 && (axes == 3 || axes == 5 || axes == 6)) || axes == 7) {
+    const uint64_t id = set.start_z * m_dims[0] * m_dims[1] + set.start_y * m_dims[0] + set.start_x;
+    m_blocks.push_back(id << 3 | axes);
+    return;
+  }
 
-        // Element (1, 0, 1)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
+  auto [subsets, lev] = m_partition_S_XYZ(set, 0);
+  for (auto& sub : subsets)
+    m_list_blocks(sub);
+}
 
-        // Element (0, 1, 1)
-        id2 = id + m_dims[0] * (m_dims[1] + 1);
-        m_morton_buf[++morton_id] = m_coeff_buf[id2];
+template <typename T>
+void sperr::SPECK3D_INT_ENC<T>::m_deposit_blocks()
+{
+  // Elements of a block are laid out with X varying the fastest, then Y, then Z.
+  const size_t row = m_dims[0];
+  const size_t plane = m_dims[0] * m_dims[1];
+  auto* dst = m_morton_buf.data();
+
+  for (auto block : m_blocks) {
+    const auto* const src = m_coeff_buf.data() + (block >> 3);
+    switch (block & 7) {
+      case 0:  // A single element
+        *dst++ = src[0];
+        break;
+      case 1:  // 2 elements along X
+        *dst++ = src[0];
+        *dst++ = src[1];
+        break;
+      case 2:  // 2 elements along Y
+        *dst++ = src[0];
+        *dst++ = src[row];
+        break;
+      case 4:  // 2 elements along Z
+        *dst++ = src[0];
+        *dst++ = src[plane];
+        break;
+      case 3:  // 2x2 elements on an XY plane
+        *dst++ = src[0];
+        *dst++ = src[1];
+        *dst++ = src[row];
+        *dst++ = src[row + 1];
+        break;
+      case 5:  // 2x2 elements on an XZ plane
+        *dst++ = src[0];
+        *dst++ = src[1];
+        *dst++ = src[plane];
+        *dst++ = src[plane + 1];
+        break;
+      case 6:  // 2x2 elements on a YZ plane
+        *dst++ = src[0];
+        *dst++ = src[row];
+        *dst++ = src[plane];
+        *dst++ = src[plane + row];
+        break;
+      default:  // 2x2x2 elements
+        *dst++ = src[0];
+        *dst++ = src[1];
+        *dst++ = src[row];
+        *dst++ = src[row + 1];
+        *dst++ = src[plane];
+        *dst++ = src[plane + 1];
+        *dst++ = src[plane + row];
+        *dst++ = src[plane + row + 1];
+    }
+  }
+  assert(dst == m_morton_buf.data() + m_morton_buf.size());
+}
 
-        // Element (1, 1, 1)
-        m_morton_buf[++morton_id] = m_coeff_buf[++id2];
+template <typename T>
+auto sperr::SPECK3D_INT_ENC<T>::m_set_max_idx(const Set3D& set) const -> size_t
+{
+  // The first subset produced by `m_partition_S_XYZ()` is never empty, and the second non-empty
+  //    subset immediately follows it in the morton order.
+  const auto len0 = size_t(set.length_x - set.length_x / 2) *
+                    size_t(set.length_y - set.length_y / 2) *
+                    size_t(set.length_z - set.length_z / 2);
+  return set.get_morton() + len0;
+}
 
-        return;
-      }
-      else
-        break;  // Fall back to the recursive case.
-    }
-    default:
-      break;  // Fall back to the recursive case.
+template <typename T>
+auto sperr::SPECK3D_INT_ENC<T>::m_record_max(Set3D set) -> uint_type
+{
+  // Small sets are scanned as a whole; they occupy a contiguous range of `m_morton_buf`.
+  if (set.num_elem() <= SCAN_LEN) {
+    const auto first = m_morton_buf.cbegin() + set.get_morton();
+    return std::accumulate(first, first + set.num_elem(), uint_type{0},
+                           [](auto a, auto b) { return std::max(a, b); });
   }
 
-  // The recursive case.
   auto [subsets, lev] = m_partition_S_XYZ(set, 0);
+  auto max = uint_type{0};
   for (auto& sub : subsets)
-    m_deposit_set(sub);
+    max = std::max(max, m_record_max(sub));
+  m_set_max[m_set_max_idx(set)] = max;
+  return max;
 }
 
 template <typename T>
 void sperr::SPECK3D_INT_ENC<T>::m_additional_initialization()
 {
-  // For the encoder, this function re-organizes the coefficients in a morton order.
+  // For the encoder, this function re-organizes the coefficients in a morton order, and then
+  //    records the maximum magnitude of every set.
   //
   m_morton_buf.resize(m_dims[0] * m_dims[1] * m_dims[2]);
+  m_set_max.resize(m_morton_buf.size());
 
   // The same traversing order as in `SPECK3D_INT::m_sorting_pass()`
+  //    Blocks that make up the morton order are listed only when the dimension changes.
+  const auto new_dims = (m_blocks_dims != m_dims);
+  if (new_dims) {
+    m_blocks_dims = m_dims;
+    m_blocks.clear();
+  }
   size_t morton_offset = 0;
   for (size_t tmp = 1; tmp <= m_LIS.size(); tmp++) {
     auto idx1 = m_LIS.size() - tmp;
     for (size_t idx2 = 0; idx2 < m_LIS[idx1].size(); idx2++) {
       auto& set = m_LIS[idx1][idx2];
       set.set_morton(morton_offset);
-      m_deposit_set(set);
+      if (new_dims)
+        m_list_blocks(set);
       morton_offset += set.num_elem();
     }
   }
+  m_deposit_blocks();
+  for (const auto& list : m_LIS)
+    for (const auto& set : list)
+      m_record_max(set);
 }
 
 template <typename T>
@@ -166,9 +155,13 @@ void sperr::SPECK3D_INT_ENC<T>::m_process_S(size_t idx1, size_t idx2, size_t& co
 
   // If need to output, it means the current set has unknown significance.
   if (output) {
-    auto first = m_morton_buf.cbegin() + set.get_morton();
-    auto last = first + set.num_elem();
-    is_sig = std::any_of(first, last, [thld = m_threshold](auto v) { return v >= thld; });
+    if (set.num_elem() > SCAN_LEN)
+      is_sig = m_set_max[m_set_max_idx(set)] >= m_threshold;
+    else {
+      auto first = m_morton_buf.cbegin() + set.get_morton();
+      auto last = first + set.num_elem();
+      is_sig = std::any_of(first, last, [thld = m_threshold](auto v) { return v >= thld; });
+    }
     m_bit_buffer.wbit(is_sig);
   }
 
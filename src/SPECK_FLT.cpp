@@ -1,4 +1,5 @@
 #include "SPECK_FLT.h"
+#include "Quantize_Kernels.h"
 
 #include <algorithm>
 #include <cassert>
@@ -6,8 +7,13 @@
 #include <cfloat>  // FLT_ROUNDS
 #include <cmath>
 #include <cstring>
+#include <limits>
 #include <numeric>
 
+#if __cplusplus >= 202002L
+#include <bit>
+#endif
+
 template <typename T>
 void sperr::SPECK_FLT::copy_data(const T* p, size_t len)
 {
@@ -21,7 +27,7 @@ template void sperr::SPECK_FLT::copy_data(const float*, size_t);
 
 void sperr::SPECK_FLT::take_data(sperr::vecd_type&& buf)
 {
-  m_vals_d = std::move(buf);
+  std::swap(m_vals_d, buf);
 }
 
 auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
@@ -57,11 +63,39 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
 
   // Bitstream parser 2.1: based on the number of bitplanes, decide on an integer length to use,
   // and instantiate the proper decoder. It will be the decoder who parses the SPECK bitstream.
+  //    In code block mode, a table of the stream length of every block comes first, and the
+  //    integer length is decided by the block with the most bitplanes. Any block could be
+  //    truncated, and a block that doesn't even keep its header is decoded as all zeros.
+  //    The truncation could also cut into the block count or the length table, in which case
+  //    no block data is available and all blocks are decoded as zeros.
   auto pos = m_condi_bitstream.size();
-  auto remaining_len = len - pos;
-  assert(remaining_len >= SPECK_INT<uint8_t>::header_size);
-  const uint8_t* const speck_p = ptr + pos;
-  const auto num_bitplanes = speck_int_get_num_bitplanes(speck_p);
+  const auto code_blocks = m_conditioner.has_code_blocks(m_condi_bitstream[0]);
+  auto block_lens = std::vector<uint64_t>();
+  auto num_bitplanes = size_t{0};
+  if (code_blocks) {
+    const size_t num_blocks = pos < len ? ptr[pos++] : m_code_block_extents().size();
+    block_lens.assign(num_blocks, 0);
+    const auto table_len = num_blocks * sizeof(uint64_t);
+    if (len - pos >= table_len) {
+      std::memcpy(block_lens.data(), ptr + pos, table_len);
+      pos += table_len;
+    }
+    else
+      pos = len;
+    auto block_pos = pos;
+    for (auto& block_len : block_lens) {
+      block_len = std::min(block_len, uint64_t{len - block_pos});
+      if (block_len >= SPECK_INT<uint8_t>::header_size) {
+        const size_t block_bitplanes = speck_int_get_num_bitplanes(ptr + block_pos);
+        num_bitplanes = std::max(num_bitplanes, block_bitplanes);
+      }
+      block_pos += block_len;
+    }
+  }
+  else {
+    assert(len - pos >= SPECK_INT<uint8_t>::header_size);
+    num_bitplanes = speck_int_get_num_bitplanes(ptr + pos);
+  }
   if (num_bitplanes <= 8)
     m_uint_flag = UINTType::UINT8;
   else if (num_bitplanes <= 16)
@@ -72,18 +106,39 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
     m_uint_flag = UINTType::UINT64;
 
   m_instantiate_int_vec();
-  m_instantiate_decoder();
 
   // Bitstream parser 2.2: extract and parse SPECK stream.
   //    A situation to be considered here is that the speck bitstream is only partially available
   //    as the result of progressive access. In that case, the available speck stream is simply
   //    shorter than what the header reports.
-  auto speck_suppose_len =
-      std::visit([speck_p](auto&& dec) { return dec->get_stream_full_len(speck_p); }, m_decoder);
-  auto speck_len = std::min(size_t{speck_suppose_len}, remaining_len);
-  std::visit([speck_p, speck_len](auto&& dec) { return dec->use_bitstream(speck_p, speck_len); },
-             m_decoder);
-  pos += speck_len;
+  if (code_blocks) {
+    const auto empty = std::array<uint8_t, SPECK_INT<uint8_t>::header_size>{};
+    m_block_decoders.resize(block_lens.size());
+    for (size_t b = 0; b < block_lens.size(); b++) {
+      m_instantiate_decoder(m_block_decoders[b]);
+      const uint8_t* const block_p = ptr + pos;
+      const size_t block_len = block_lens[b];
+      std::visit(
+          [&](auto&& dec) {
+            if (block_len >= empty.size())
+              dec->use_bitstream(block_p, block_len);
+            else
+              dec->use_bitstream(empty.data(), empty.size());
+          },
+          m_block_decoders[b]);
+      pos += block_len;
+    }
+  }
+  else {
+    m_instantiate_decoder(m_decoder);
+    const uint8_t* const speck_p = ptr + pos;
+    auto speck_suppose_len =
+        std::visit([speck_p](auto&& dec) { return dec->get_stream_full_len(speck_p); }, m_decoder);
+    auto speck_len = std::min(size_t{speck_suppose_len}, len - pos);
+    std::visit([speck_p, speck_len](auto&& dec) { return dec->use_bitstream(speck_p, speck_len); },
+               m_decoder);
+    pos += speck_len;
+  }
   assert(pos <= len);
 
   // Bitstream parser 3: extract Outlier Coder stream if there's any.
@@ -92,7 +147,7 @@ auto sperr::SPECK_FLT::use_bitstream(const void* p, size_t len) -> RTNType
   m_has_outlier = false;
   if (pos < len) {
     const uint8_t* const out_p = ptr + pos;
-    remaining_len = len - pos;
+    const auto remaining_len = len - pos;
     if (remaining_len >= SPECK_INT<uint8_t>::header_size) {
       auto suppose_len = m_out_coder.get_stream_full_len(out_p);
       assert(suppose_len >= remaining_len);
@@ -114,8 +169,20 @@ void sperr::SPECK_FLT::append_encoded_bitstream(vec8_type& buf) const
   std::copy(m_condi_bitstream.cbegin(), m_condi_bitstream.cend(), std::back_inserter(buf));
 
   if (!m_conditioner.is_constant(m_condi_bitstream[0])) {
-    // Append SPECK_INT bitstream.
-    std::visit([&buf](auto&& enc) { enc->append_encoded_bitstream(buf); }, m_encoder);
+    // Append SPECK_INT bitstream(s). In code block mode, the number of blocks and the length
+    //    of each block stream come first.
+    if (m_conditioner.has_code_blocks(m_condi_bitstream[0])) {
+      buf.push_back(static_cast<uint8_t>(m_block_encoders.size()));
+      for (const auto& enc : m_block_encoders) {
+        const uint64_t len = std::visit([](auto&& e) { return e->encoded_bitstream_len(); }, enc);
+        const auto* const len_p = reinterpret_cast<const uint8_t*>(&len);
+        std::copy(len_p, len_p + sizeof(len), std::back_inserter(buf));
+      }
+      for (const auto& enc : m_block_encoders)
+        std::visit([&buf](auto&& e) { e->append_encoded_bitstream(buf); }, enc);
+    }
+    else
+      std::visit([&buf](auto&& enc) { enc->append_encoded_bitstream(buf); }, m_encoder);
 
     // Append outlier coder bitstream.
     if (m_has_outlier)
@@ -190,25 +257,60 @@ void sperr::SPECK_FLT::set_dims(dims_type dims)
   m_dims = dims;
 }
 
+void sperr::SPECK_FLT::set_xform_threads(size_t n)
+{
+  m_xform_threads = n;
+  m_cdf.set_num_threads(n);
+}
+
+void sperr::SPECK_FLT::set_code_blocks(bool flag)
+{
+  m_code_blocks = flag;
+}
+
+void sperr::SPECK_FLT::use_dwt_plan(std::shared_ptr<const DWT_Plan> plan)
+{
+  m_cdf.use_plan(std::move(plan));
+}
+
+void sperr::SPECK_FLT::enable_timing(bool flag)
+{
+  m_timing = flag;
+}
+
+auto sperr::SPECK_FLT::view_timing() const -> const StageTimes&
+{
+  return m_times;
+}
+
+void sperr::SPECK_FLT::m_start_stage()
+{
+  if (m_timing)
+    m_stage_start = std::chrono::steady_clock::now();
+}
+
+void sperr::SPECK_FLT::m_end_stage(StageType stage, size_t num_bytes)
+{
+  if (m_timing) {
+    const auto elapsed = std::chrono::steady_clock::now() - m_stage_start;
+    m_times.record(stage, std::chrono::duration<double>(elapsed).count(), num_bytes);
+  }
+}
+
 auto sperr::SPECK_FLT::integer_len() const -> size_t
 {
   switch (m_uint_flag) {
     case UINTType::UINT8:
       assert(m_vals_ui.index() == 0);
-      // Either this is an encoder, or this is a decoder.
-      assert(m_encoder.index() == 0 || m_decoder.index() == 0);
       return sizeof(uint8_t);
     case UINTType::UINT16:
       assert(m_vals_ui.index() == 1);
-      assert(m_encoder.index() == 1 || m_decoder.index() == 1);
       return sizeof(uint16_t);
     case UINTType::UINT32:
       assert(m_vals_ui.index() == 2);
-      assert(m_encoder.index() == 2 || m_decoder.index() == 2);
       return sizeof(uint32_t);
     default:
       assert(m_vals_ui.index() == 3);
-      assert(m_encoder.index() == 3 || m_decoder.index() == 3);
       return sizeof(uint64_t);
   }
 }
@@ -234,36 +336,263 @@ void sperr::SPECK_FLT::m_instantiate_int_vec()
   }
 }
 
+auto sperr::SPECK_FLT::m_code_block_extents() const -> std::vector<std::array<dims_type, 2>>
+{
+  // Split every axis longer than one in halves, the same way as one level of wavelet transform.
+  auto halves = std::array<std::array<size_t, 2>, 3>();
+  for (size_t i = 0; i < 3; i++) {
+    if (m_dims[i] > 1)
+      halves[i] = sperr::calc_approx_detail_len(m_dims[i], 1);
+    else
+      halves[i] = {m_dims[i], 0};
+  }
+
+  auto extents = std::vector<std::array<dims_type, 2>>();
+  extents.reserve(8);
+  for (size_t z = 0; z < 2; z++)
+    for (size_t y = 0; y < 2; y++)
+      for (size_t x = 0; x < 2; x++) {
+        const auto len = dims_type{halves[0][x], halves[1][y], halves[2][z]};
+        const auto start = dims_type{x * halves[0][0], y * halves[1][0], z * halves[2][0]};
+        if (len[0] * len[1] * len[2] != 0)
+          extents.push_back({start, len});
+      }
+
+  return extents;
+}
+
+auto sperr::SPECK_FLT::m_encode_code_blocks() -> RTNType
+{
+  const auto extents = m_code_block_extents();
+  m_block_encoders.resize(extents.size());
+  for (auto& enc : m_block_encoders)
+    m_instantiate_encoder(enc);
+
+  auto rtns = std::vector<RTNType>(extents.size(), RTNType::Good);
+  std::visit(
+      [&](auto&& vals) {
+        using uint_t = typename std::remove_reference_t<decltype(vals)>::value_type;
+
+#pragma omp parallel for num_threads(m_xform_threads) schedule(dynamic)
+        for (size_t b = 0; b < extents.size(); b++) {
+          // Reuse the buffers that this encoder consumed last time.
+          auto& enc = std::get<std::unique_ptr<SPECK_INT<uint_t>>>(m_block_encoders[b]);
+          const auto [start, len] = extents[b];
+          auto coeffs = enc->release_coeffs();
+          auto signs = enc->release_signs();
+          coeffs.resize(len[0] * len[1] * len[2]);
+          signs.resize(coeffs.size());
+          size_t idx = 0;
+          for (size_t z = start[2]; z < start[2] + len[2]; z++)
+            for (size_t y = start[1]; y < start[1] + len[1]; y++) {
+              const auto row = (z * m_dims[1] + y) * m_dims[0];
+              for (size_t x = start[0]; x < start[0] + len[0]; x++) {
+                coeffs[idx] = vals[row + x];
+                signs.wbit(idx++, m_sign_array.rbit(row + x));
+              }
+            }
+
+          enc->set_dims(len);
+          rtns[b] = enc->use_coeffs(std::move(coeffs), std::move(signs));
+          if (rtns[b] == RTNType::Good)
+            enc->encode();
+        }
+
+        vals = std::remove_reference_t<decltype(vals)>();
+      },
+      m_vals_ui);
+  m_sign_array = Bitmask();
+
+  for (auto rtn : rtns) {
+    if (rtn != RTNType::Good)
+      return rtn;
+  }
+  return RTNType::Good;
+}
+
+void sperr::SPECK_FLT::m_decode_code_blocks()
+{
+  const auto extents = m_code_block_extents();
+  assert(extents.size() == m_block_decoders.size());
+  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
+  m_sign_array.resize(total_vals);
+
+  std::visit(
+      [&](auto&& vals) {
+        using uint_t = typename std::remove_reference_t<decltype(vals)>::value_type;
+        vals.resize(total_vals);
+
+#pragma omp parallel for num_threads(m_xform_threads) schedule(dynamic)
+        for (size_t b = 0; b < extents.size(); b++) {
+          auto& dec = std::get<std::unique_ptr<SPECK_INT<uint_t>>>(m_block_decoders[b]);
+          dec->set_dims(extents[b][1]);
+          dec->decode();
+        }
+
+        // Scatter blocks back serially, as neighboring blocks share words of `m_sign_array`.
+        for (size_t b = 0; b < extents.size(); b++) {
+          const auto [start, len] = extents[b];
+          const auto& dec = std::get<std::unique_ptr<SPECK_INT<uint_t>>>(m_block_decoders[b]);
+          const auto& coeffs = dec->view_coeffs();
+          const auto& signs = dec->view_signs();
+          size_t idx = 0;
+          for (size_t z = start[2]; z < start[2] + len[2]; z++)
+            for (size_t y = start[1]; y < start[1] + len[1]; y++) {
+              const auto row = (z * m_dims[1] + y) * m_dims[0];
+              for (size_t x = start[0]; x < start[0] + len[0]; x++) {
+                vals[row + x] = coeffs[idx];
+                m_sign_array.wbit(row + x, signs.rbit(idx++));
+              }
+            }
+        }
+      },
+      m_vals_ui);
+}
+
+auto sperr::SPECK_FLT::m_code_blocks_len() const -> size_t
+{
+  auto len = 1 + m_block_encoders.size() * sizeof(uint64_t);
+  for (const auto& enc : m_block_encoders)
+    len += std::visit([](auto&& e) { return e->encoded_bitstream_len(); }, enc);
+  return len;
+}
+
 auto sperr::SPECK_FLT::m_estimate_mse_midtread(double q) const -> double
 {
   assert(!m_vals_d.empty());
 
+  // The error is evaluated the same way as `m_midtread_quantize()` rounds a value, which is
+  //    a few times faster than `std::remainder()`.
   const auto len = m_vals_d.size();
   const size_t stride_size = 4096;
   const size_t num_strides = len / stride_size;
   auto tmp_buf = vecd_type(num_strides + 1);
+  const auto inv = 1.0 / q;
+  auto sum_sq_err = [q, inv](auto init, auto v) {
+    auto diff = v - q * std::nearbyint(v * inv);
+    return init + diff * diff;
+  };
 
   for (size_t i = 0; i < num_strides; i++) {
     const auto beg = m_vals_d.cbegin() + i * stride_size;
-    tmp_buf[i] = std::accumulate(beg, beg + stride_size, 0.0, [q](auto init, auto v) {
-      auto diff = std::remainder(v, q);
-      return init + diff * diff;
-    });
+    tmp_buf[i] = std::accumulate(beg, beg + stride_size, 0.0, sum_sq_err);
   }
 
   // Let's also process the last stride.
-  tmp_buf[num_strides] = 0.0;
   tmp_buf[num_strides] = std::accumulate(m_vals_d.cbegin() + num_strides * stride_size,
-                                         m_vals_d.cend(), 0.0, [q](auto init, auto v) {
-                                           auto diff = std::remainder(v, q);
-                                           return init + diff * diff;
-                                         });
+                                         m_vals_d.cend(), 0.0, sum_sq_err);
   const auto total_sum = std::accumulate(tmp_buf.cbegin(), tmp_buf.cend(), 0.0);
   const auto mse = total_sum / static_cast<double>(len);
 
   return mse;
 }
 
+auto sperr::SPECK_FLT::m_estimate_q_psnr(double q, double t_mse) const -> double
+{
+  // The candidates are q_k = q * 2^(-k/4), k = 0, 1, 2, ..., i.e., four of them halve q.
+  //    Coefficient magnitudes are binned on the same quarter-octave grid, so the MSE of every
+  //    candidate is bounded from the bins alone, after a single pass over the coefficients:
+  //    - magnitudes no bigger than q_k / 2 are quantized to zero, and contribute v^2;
+  //    - magnitudes in (q_k / 2, sqrt(2) * q_k] are quantized to q_k, and contribute (|v|-q_k)^2;
+  //    - bigger magnitudes contribute somewhere between the smallest and the biggest squared
+  //      quantization error over their bin, which are 0 and q_k^2 / 4 for bins wider than q_k.
+  //    Bin j holds magnitudes in (q/2 * 2^(-(j+1)/4), q/2 * 2^(-j/4)], with the bins beyond both
+  //    ends merged. The bin of a magnitude is read from the exponent and mantissa bits of its
+  //    scaled value, i.e., the position of that value within an octave, and within a quarter.
+  //
+  //    A candidate whose bounds are both below (or both above) `t_mse` is decided right away.
+  //    Only a candidate whose bounds straddle `t_mse` is evaluated exactly, so the chosen q
+  //    is always the same as evaluating every candidate exactly, no matter how the data spread
+  //    within bins.
+  //
+  //    Binning costs about two exact evaluations, and the first or second candidate is often
+  //    the answer, so those two are evaluated exactly before any binning happens.
+  //
+  const auto q0 = q;
+  for (int i = 0; i < 2; i++) {
+    if (m_estimate_mse_midtread(q) <= t_mse)
+      return q;
+    q /= std::exp2(0.25);
+  }
+
+  constexpr int64_t lowest = -64;
+  constexpr int64_t num_bins = 4 * 64 - lowest;
+  auto cnt = std::array<double, num_bins>();
+  auto sum = std::array<double, num_bins>();
+  auto sum2 = std::array<double, num_bins>();
+  const auto quarter1 = static_cast<uint64_t>(std::ldexp(std::exp2(0.75) - 1.0, 52));
+  const auto quarter2 = static_cast<uint64_t>(std::ldexp(std::exp2(0.5) - 1.0, 52));
+  const auto quarter3 = static_cast<uint64_t>(std::ldexp(std::exp2(0.25) - 1.0, 52));
+  const auto inv = 2.0 / q0;
+  for (auto v : m_vals_d) {
+    const auto mag = std::abs(v);
+    const auto scaled = mag * inv;
+    auto bits = uint64_t{0};
+    std::memcpy(&bits, &scaled, sizeof(bits));
+    const auto mantissa = bits & ((uint64_t{1} << 52) - 1);
+    auto j = (int64_t{1022} - int64_t(bits >> 52)) * 4 + (mantissa <= quarter1) +
+             (mantissa <= quarter2) + (mantissa <= quarter3) + (mantissa == 0);
+    j = std::clamp(j, lowest, num_bins + lowest - 1) - lowest;
+    cnt[j] += 1.0;
+    sum[j] += mag;
+    sum2[j] += mag * mag;
+  }
+
+  // The upper edge of every bin.
+  auto edges = std::array<double, num_bins>();
+  for (int64_t j = 0; j < num_bins; j++)
+    edges[j] = q0 * 0.5 * std::exp2(double(-(j + lowest)) / 4.0);
+
+  // The smallest and the biggest squared quantization error of magnitudes in [lo, hi], which
+  //    is zero at multiples of q, and peaks at odd multiples of q / 2.
+  auto err2_range = [](double q, double lo, double hi) -> std::array<double, 2> {
+    if (hi - lo >= q)
+      return {0.0, q * q / 4.0};
+    auto err2 = [q](double x) { return std::pow(x - q * std::round(x / q), 2.0); };
+    const auto err2_lo = err2(lo), err2_hi = err2(hi);
+    const auto min = std::ceil(lo / q) * q <= hi ? 0.0 : std::min(err2_lo, err2_hi);
+    const auto max = (std::ceil(lo / q - 0.5) + 0.5) * q <= hi ? q * q / 4.0
+                                                              : std::max(err2_lo, err2_hi);
+    return {min, max};
+  };
+
+  // Margins that absorb round-off, both in binning the magnitudes and in the sums.
+  const auto len = static_cast<double>(m_vals_d.size());
+  const auto pass = t_mse * len * (1.0 - 1e-9);
+  const auto fail = t_mse * len * (1.0 + 1e-9);
+  for (int64_t k = 2; k - lowest < num_bins - 1; k++) {
+    auto lower = 0.0, upper = 0.0;
+    for (int64_t j = 0; j < num_bins; j++) {
+      const auto bin = j + lowest;
+      if (bin >= k) {
+        lower += sum2[j];
+        upper += sum2[j];
+      }
+      else if (bin >= k - 6) {
+        const auto exact = sum2[j] - 2.0 * q * sum[j] + q * q * cnt[j];
+        lower += exact;
+        upper += exact;
+      }
+      else if (cnt[j] > 0.0) {
+        const auto hi = (j == 0) ? std::numeric_limits<double>::infinity() : edges[j];
+        const auto [min, max] = err2_range(q, edges[j + 1] * (1.0 - 1e-9), hi * (1.0 + 1e-9));
+        lower += cnt[j] * min;
+        upper += cnt[j] * max;
+      }
+    }
+    if (upper <= pass)
+      return q;
+    if (lower <= fail && m_estimate_mse_midtread(q) <= t_mse)
+      return q;
+    q /= std::exp2(0.25);
+  }
+
+  // The target is beyond the range of the bins; evaluate the remaining candidates exactly.
+  while (m_estimate_mse_midtread(q) > t_mse)
+    q /= std::exp2(0.25);
+  return q;
+}
+
 auto sperr::SPECK_FLT::m_estimate_q(double param, bool high_prec) const -> double
 {
   switch (m_mode) {
@@ -272,9 +601,7 @@ auto sperr::SPECK_FLT::m_estimate_q(double param, bool high_prec) const -> doubl
       // quantization threshold should be (2.0 * sqrt(3.0) * rmse).
       const auto t_mse = (param * param) * std::pow(10.0, -m_quality / 10.0);
       auto q = 2.0 * std::sqrt(t_mse * 3.0);
-      while (m_estimate_mse_midtread(q) > t_mse)
-        q /= std::exp2(0.25);  // Four adjustments would effectively halve q.
-      return q;
+      return m_estimate_q_psnr(q, t_mse);
     }
     case CompMode::PWE:
       return m_quality * 1.5;
@@ -307,6 +634,29 @@ auto sperr::SPECK_FLT::m_estimate_q(double param, bool high_prec) const -> doubl
   }
 }
 
+auto sperr::SPECK_FLT::m_predict_lossless_bits() const -> size_t
+{
+  // A significant coefficient costs at least its significant bits plus a sign bit, so their sum
+  //    is a lower bound of a complete encoding. The significance tests of sets add another 8.6%
+  //    to 9.4% on top of it (measured on a few 2D and 3D fields at uint32_t precision).
+  //    Only 8% is added here, because an estimate too small merely chooses high precision for a
+  //    budget that's slightly too low for it, while an estimate too big costs a second encoding.
+  assert(m_vals_ui.index() == 2);
+  const auto& vals = std::get<2>(m_vals_ui);
+  auto bits = size_t{0};
+  for (auto v : vals) {
+#if __cplusplus >= 202002L
+    bits += std::bit_width(v) + size_t{v != 0};
+#else
+    auto width = size_t{v != 0};
+    for (; v != 0; v >>= 1)
+      width++;
+    bits += width;
+#endif
+  }
+  return static_cast<size_t>(double(bits) * 1.08);
+}
+
 auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
 {
   // Make sure that the rounding mode is what we wanted.
@@ -317,11 +667,11 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
   assert(FLT_ROUNDS == 1);
 
   // Find the biggest floating point value, then get its quantized integer.
-  auto maxd = *std::max_element(m_vals_d.cbegin(), m_vals_d.cend(),
-                                [](auto a, auto b) { return std::abs(a) < std::abs(b); });
+  const auto isa = sperr::best_isa();
+  const auto maxd = sperr::max_magnitude(m_vals_d.data(), m_vals_d.size(), isa);
   std::feclearexcept(FE_INVALID);
   assert(m_q > 0.0);
-  auto maxll = std::llrint(std::abs(maxd) / m_q);
+  auto maxll = std::llrint(maxd / m_q);
   if (std::fetestexcept(FE_INVALID))
     return RTNType::FE_Invalid;
 
@@ -341,28 +691,12 @@ auto sperr::SPECK_FLT::m_midtread_quantize() -> RTNType
   std::visit([total_vals](auto&& vec) { vec.resize(total_vals); }, m_vals_ui);
   m_sign_array.resize(total_vals);
 
+  // Round every value and pack its sign with the kernel of the integer length just decided.
   std::visit(
-      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q](auto&& vec) {
-        auto inv = 1.0 / q;
-        auto bits_x64 = vals_d.size() - vals_d.size() % 64;
-
-        // Process 64 values at a time.
-        for (size_t i = 0; i < bits_x64; i += 64) {
-          auto bits64 = uint64_t{0};
-          for (size_t j = 0; j < 64; j++) {
-            auto ll = std::llrint(vals_d[i + j] * inv);
-            bits64 |= uint64_t{ll >= 0} << j;
-            vec[i + j] = std::abs(ll);
-          }
-          signs.wlong(i, bits64);
-        }
-
-        // Process the remaining bits.
-        for (size_t i = bits_x64; i < vals_d.size(); i++) {
-          auto ll = std::llrint(vals_d[i] * inv);
-          signs.wbit(i, (ll >= 0));
-          vec[i] = std::abs(ll);
-        }
+      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q, isa](auto&& vec) {
+        using uint_t = typename std::remove_reference_t<decltype(vec)>::value_type;
+        const auto& kernels = sperr::quantize_kernels<uint_t>(isa);
+        kernels.quantize(vals_d.data(), vals_d.size(), 1.0 / q, vec.data(), signs);
       },
       m_vals_ui);
 
@@ -374,25 +708,13 @@ void sperr::SPECK_FLT::m_midtread_inv_quantize()
   assert(m_sign_array.size() == std::visit([](auto&& vec) { return vec.size(); }, m_vals_ui));
   assert(m_q > 0.0);
 
-  const auto tmpd = std::array<double, 2>{-1.0, 1.0};
   m_vals_d.resize(m_sign_array.size());
 
   std::visit(
-      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q, tmpd](auto&& vec) {
-        auto bits_x64 = vals_d.size() - vals_d.size() % 64;
-
-        // Process 64 values at a time.
-        for (size_t i = 0; i < bits_x64; i += 64) {
-          const auto bits64 = signs.rlong(i);
-          for (size_t j = 0; j < 64; j++) {
-            auto bit = (bits64 >> j) & uint64_t{1};
-            vals_d[i + j] = q * static_cast<double>(vec[i + j]) * tmpd[bit];
-          }
-        }
-
-        // Process the remaining bits.
-        for (size_t i = bits_x64; i < vals_d.size(); i++)
-          vals_d[i] = q * static_cast<double>(vec[i]) * tmpd[signs.rbit(i)];
+      [&vals_d = m_vals_d, &signs = m_sign_array, q = m_q](auto&& vec) {
+        using uint_t = typename std::remove_reference_t<decltype(vec)>::value_type;
+        const auto& kernels = sperr::quantize_kernels<uint_t>(sperr::best_isa());
+        kernels.inv_quantize(vec.data(), signs, vals_d.size(), q, vals_d.data());
       },
       m_vals_ui);
 }
@@ -407,13 +729,17 @@ auto sperr::SPECK_FLT::compress() -> RTNType
     return RTNType::CompModeUnknown;
 
   m_has_outlier = false;
+  m_times = StageTimes();
 
   // Step 1: data goes through the conditioner
   //    Believe it or not, there are constant fields passed in for compression!
   //    Let's detect that case and skip the rest of the compression routine if it occurs.
+  m_start_stage();
   m_condi_bitstream = m_conditioner.condition(m_vals_d, m_dims);
-  if (m_conditioner.is_constant(m_condi_bitstream[0]))
+  if (m_conditioner.is_constant(m_condi_bitstream[0])) {
+    m_end_stage(StageType::Condition, m_condi_bitstream.size());
     return RTNType::Good;
+  }
 
   // Collect information for different compression modes.
   auto param_q = 0.0;  // assist estimating `m_q`.
@@ -430,40 +756,65 @@ auto sperr::SPECK_FLT::compress() -> RTNType
     }
     default:;  // So the compiler doesn't complain about missing switch cases.
   }
+  m_end_stage(StageType::Condition, m_condi_bitstream.size());
 
   // Step 2: wavelet transform
-  m_cdf.take_data(std::move(m_vals_d), m_dims);
+  m_start_stage();
+  auto rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
+  if (rtn != RTNType::Good)
+    return rtn;
   m_wavelet_xform();
   m_vals_d = m_cdf.release_data();
+  m_end_stage(StageType::Xform, m_vals_d.size() * sizeof(double));
 
   // Step 2.1: Estimate `m_q`, and store it as part of `m_condi_stream`.
   if (m_mode == CompMode::Rate) {
     // In fixed-rate mode, `param_q` is the wavelet coefficient of the largest magnitude.
-    auto itr = std::max_element(m_vals_d.cbegin(), m_vals_d.cend(),
-                                [](auto a, auto b) { return std::abs(a) < std::abs(b); });
-    param_q = std::abs(*itr);
+    param_q = sperr::max_magnitude(m_vals_d.data(), m_vals_d.size(), sperr::best_isa());
   }
 
   bool high_prec = false;
 FIXED_RATE_HIGH_PREC_LABEL:
+  m_start_stage();
   m_q = m_estimate_q(param_q, high_prec);
   assert(m_q > 0.0);
   m_conditioner.save_q(m_condi_bitstream, m_q);
 
   // Step 3: quantize floating-point coefficients to integers.
   // This step also establishes the integer length used by the encoder/decoder.
-  auto rtn = m_midtread_quantize();
+  rtn = m_midtread_quantize();
   if (rtn != RTNType::Good)
     return rtn;
+  m_end_stage(StageType::Quantize,
+              std::visit([](auto&& vec) { return vec.size() * sizeof(vec[0]); }, m_vals_ui) +
+                  m_sign_array.view_buffer().size() * sizeof(uint64_t));
+
+  // In CompMode::Rate mode, a budget bigger than a complete encoding at the current precision
+  //    would leave bits unused. When that's predicted, raise the precision before encoding.
+  if (m_mode == CompMode::Rate && high_prec == false) {
+    auto budget = static_cast<size_t>(m_quality * double(total_vals));
+    if (budget > m_predict_lossless_bits()) {
+      high_prec = true;
+      m_times.rate_predicted++;
+      goto FIXED_RATE_HIGH_PREC_LABEL;
+    }
+  }
 
   // CompMode::PWE only: perform outlier coding: find out all the outliers, and encode them!
+  //    Reconstructing the values to compare against is accounted as quantization and transform.
   if (m_mode == CompMode::PWE) {
+    m_start_stage();
     m_midtread_inv_quantize();
+    m_end_stage(StageType::Quantize, m_vals_d.size() * sizeof(double));
+    m_start_stage();
     rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
     if (rtn != RTNType::Good)
       return rtn;
     m_inverse_wavelet_xform(false);  // No multi-resolution needed!
     m_vals_d = m_cdf.release_data();
+    m_end_stage(StageType::Xform, m_vals_d.size() * sizeof(double));
+
+    m_start_stage();
     auto LOS = std::vector<Outlier>();
     LOS.reserve(0.04 * total_vals);  // Reserve space to hold about 4% of total values.
     for (size_t i = 0; i < total_vals; i++) {
@@ -482,10 +833,23 @@ FIXED_RATE_HIGH_PREC_LABEL:
       if (rtn != RTNType::Good)
         return rtn;
     }
+    m_end_stage(StageType::Outlier, m_has_outlier ? m_out_coder.encoded_bitstream_len() : 0);
   }
 
   // Step 4: Integer SPECK encoding
-  m_instantiate_encoder();
+  //    Code blocks are not used in fixed-rate mode, which needs a budget on the whole stream.
+  m_start_stage();
+  const auto code_blocks = m_code_blocks && m_mode != CompMode::Rate;
+  m_conditioner.mark_code_blocks(m_condi_bitstream, code_blocks);
+  if (code_blocks) {
+    rtn = m_encode_code_blocks();
+    if (rtn != RTNType::Good)
+      return rtn;
+    m_end_stage(StageType::Speck, m_code_blocks_len());
+    return RTNType::Good;
+  }
+
+  m_instantiate_encoder(m_encoder);
   if (m_mode == CompMode::Rate) {
     auto budget = static_cast<size_t>(m_quality * double(total_vals));  // total num of bits
     std::visit([budget](auto&& encoder) { encoder->set_budget(budget); }, m_encoder);
@@ -520,9 +884,18 @@ FIXED_RATE_HIGH_PREC_LABEL:
     return rtn;
 
   std::visit([](auto&& encoder) { encoder->encode(); }, m_encoder);
+  m_end_stage(StageType::Speck,
+              std::visit([](auto&& encoder) { return encoder->encoded_bitstream_len(); },
+                         m_encoder));
+
+  // Take back the (consumed) coefficient and sign buffers, so the next compression of the same
+  //    size reuses their memory instead of allocating it again.
+  std::visit([&vec = m_vals_ui](auto&& enc) { vec = enc->release_coeffs(); }, m_encoder);
+  m_sign_array = std::visit([](auto&& enc) { return enc->release_signs(); }, m_encoder);
 
   // In CompMode::Rate mode, we see if there's enough bits produced. If not, we adjust `m_q`
-  //    so quantiztion is done with a higher precision.
+  //    so quantiztion is done with a higher precision. With the prediction above, this is only
+  //    a fallback for when the prediction is off.
   //    Btw I know that GOTO should be used very sparsely and with great caution. I think this
   //    is one place where it's making the code most clean and not introducing additional risks.
   //
@@ -532,6 +905,7 @@ FIXED_RATE_HIGH_PREC_LABEL:
     auto actual = std::get<2>(m_encoder)->encoded_bitstream_len() * size_t{8};
     if (actual < budget) {
       high_prec = true;
+      m_times.rate_retried++;
       goto FIXED_RATE_HIGH_PREC_LABEL;
     }
   }
@@ -545,34 +919,64 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
   // m_hierarchy.clear(); // Intentionally not clearing, reusing already-allocated memory.
   std::visit([](auto&& vec) { vec.clear(); }, m_vals_ui);
   m_sign_array.resize(0);
+  m_times = StageTimes();
 
   // `m_condi_bitstream` might be indicating a constant field, so let's see if that's
   // the case, and if it is, we don't need to go through wavelet and speck stuff anymore.
   if (m_conditioner.is_constant(m_condi_bitstream[0])) {
+    m_start_stage();
     auto rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
+    m_end_stage(StageType::Condition, m_vals_d.size() * sizeof(double));
     return rtn;
   }
 
   // Step 1: Integer SPECK decode.
-  // Note: the decoder has already parsed the bitstream in function `use_bitstream()`.
+  // Note: the decoder(s) have already parsed the bitstream in function `use_bitstream()`.
   assert(m_q > 0.0);
-  std::visit([dims = m_dims](auto&& decoder) { decoder->set_dims(dims); }, m_decoder);
-  std::visit([](auto&& decoder) { decoder->decode(); }, m_decoder);
-  std::visit([&vec = m_vals_ui](auto&& dec) { vec = dec->release_coeffs(); }, m_decoder);
-  m_sign_array = std::visit([](auto&& dec) { return dec->release_signs(); }, m_decoder);
+  m_start_stage();
+  if (m_conditioner.has_code_blocks(m_condi_bitstream[0])) {
+    if (m_block_decoders.size() != m_code_block_extents().size())
+      return RTNType::WrongLength;
+    m_decode_code_blocks();
+  }
+  else {
+    std::visit([dims = m_dims](auto&& decoder) { decoder->set_dims(dims); }, m_decoder);
+    std::visit([](auto&& decoder) { decoder->decode(); }, m_decoder);
+    std::visit([&vec = m_vals_ui](auto&& dec) { vec = dec->release_coeffs(); }, m_decoder);
+    m_sign_array = std::visit([](auto&& dec) { return dec->release_signs(); }, m_decoder);
+  }
+  m_end_stage(StageType::Speck,
+              std::visit([](auto&& vec) { return vec.size() * sizeof(vec[0]); }, m_vals_ui) +
+                  m_sign_array.view_buffer().size() * sizeof(uint64_t));
 
   // Step 2: Inverse quantization
+  //    Afterwards, the coefficient and sign buffers are handed back to the decoder, so the next
+  //    decoding of the same size reuses their memory instead of allocating it again.
+  m_start_stage();
   m_midtread_inv_quantize();
+  if (!m_conditioner.has_code_blocks(m_condi_bitstream[0])) {
+    std::visit(
+        [&signs = m_sign_array](auto&& dec, auto&& vec) {
+          using vec_t = std::decay_t<decltype(vec)>;
+          if constexpr (std::is_same_v<vec_t, std::decay_t<decltype(dec->view_coeffs())>>)
+            dec->use_coeffs(std::move(vec), std::move(signs));
+        },
+        m_decoder, m_vals_ui);
+  }
+  m_end_stage(StageType::Quantize, m_vals_d.size() * sizeof(double));
 
   // Step 3: Inverse wavelet transform
+  m_start_stage();
   auto rtn = m_cdf.take_data(std::move(m_vals_d), m_dims);
   if (rtn != RTNType::Good)
     return rtn;
   m_inverse_wavelet_xform(multi_res);
   m_vals_d = m_cdf.release_data();
+  m_end_stage(StageType::Xform, m_vals_d.size() * sizeof(double));
 
   // Side step: outlier correction, if needed
   if (m_has_outlier) {
+    m_start_stage();
     m_out_coder.set_length(m_dims[0] * m_dims[1] * m_dims[2]);
     m_out_coder.set_tolerance(m_q / 1.5);  // `m_quality` is not set during decompression.
     rtn = m_out_coder.decode();
@@ -581,9 +985,11 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
     const auto& recovered = m_out_coder.view_outlier_list();
     for (auto out : recovered)
       m_vals_d[out.pos] += out.err;
+    m_end_stage(StageType::Outlier, recovered.size() * sizeof(Outlier));
   }
 
   // Step 4: Inverse Conditioning
+  m_start_stage();
   rtn = m_conditioner.inverse_condition(m_vals_d, m_dims, m_condi_bitstream);
   if (rtn != RTNType::Good)
     return rtn;
@@ -600,6 +1006,7 @@ auto sperr::SPECK_FLT::decompress(bool multi_res) -> RTNType
         m_conditioner.inverse_condition(m_hierarchy[h], res, m_condi_bitstream);
     }
   }
+  m_end_stage(StageType::Condition, m_vals_d.size() * sizeof(double));
 
   return RTNType::Good;
 }
@@ -194,12 +194,18 @@ void sperr::SPECK_INT<T>::decode()
     m_threshold *= uint_type{2};
 
   // Marching over bitplanes.
+  //    With a complete bitstream, the refinement pass doesn't need to check for the end of the
+  //    available bits after every read.
+  const bool partial = m_avail_bits < m_total_bits;
   for (uint8_t bitplane = 0; bitplane < m_num_bitplanes; bitplane++) {
     m_sorting_pass();
     if (m_bit_buffer.rtell() >= m_avail_bits)  // Happens when a partial bitstream is available,
       break;                                   // because of progressive decoding or fixed-rate.
 
-    m_refinement_pass_decode();
+    if (partial)
+      m_refinement_pass_decode<true>();
+    else
+      m_refinement_pass_decode<false>();
     if (m_bit_buffer.rtell() >= m_avail_bits)  // Happens when a partial bitstream is available,
       break;                                   // because of progressive decoding or fixed-rate.
 
@@ -318,13 +324,30 @@ void sperr::SPECK_INT<T>::m_refinement_pass_encode()
     auto value = m_LSP_mask.rlong(i);
 
 #if __cplusplus >= 202002L
-    while (value) {
-      auto j = std::countr_zero(value);
-      const bool o1 = m_coeff_buf[i + j] >= m_threshold;
-      m_coeff_buf[i + j] -= tmp1[o1];
-      m_bit_buffer.wbit(o1);
-      value &= value - 1;
+    // Refinement bits of these 64 points are collected in a word, and written out all at once.
+    //    When all of them are significant, which is common in later bitplanes, the loop has no
+    //    branches and is vectorized.
+    if (value == 0)
+      continue;
+    const auto num_bits = std::popcount(value);
+    auto bits = uint64_t{0};
+    if (value == ~uint64_t{0}) {
+      for (size_t j = 0; j < 64; j++) {
+        const bool o1 = m_coeff_buf[i + j] >= m_threshold;
+        m_coeff_buf[i + j] -= tmp1[o1];
+        bits |= uint64_t{o1} << j;
+      }
     }
+    else {
+      for (int k = 0; value; k++) {
+        auto j = std::countr_zero(value);
+        const bool o1 = m_coeff_buf[i + j] >= m_threshold;
+        m_coeff_buf[i + j] -= tmp1[o1];
+        bits |= uint64_t{o1} << k;
+        value &= value - 1;
+      }
+    }
+    m_bit_buffer.wbits(bits, num_bits);
 #else
     if (value != 0) {
       for (size_t j = 0; j < 64; j++) {
@@ -353,6 +376,7 @@ void sperr::SPECK_INT<T>::m_refinement_pass_encode()
 }
 
 template <typename T>
+template <bool Partial>
 void sperr::SPECK_INT<T>::m_refinement_pass_decode()
 {
   // First, process significant points previously found.
@@ -363,7 +387,8 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
   // 2) We make use of the internal representation of `m_LSP_mask` and evaluate 64 bits at time.
   //    This requires evaluating any remaining bits not divisible by 64.
   // 3) During progressive or fixed-rate decoding, we need to evaluate if the bitstream is
-  //    exhausted after every read. We test it no matter what decoding mode we're in though.
+  //    exhausted after every read. This is only compiled in when `Partial` is true, i.e.,
+  //    when the bitstream is truncated; a complete bitstream never runs out in this pass.
   // 4) goto is used again. Here's it's used to jump out of a nested loop, which is an endorsed
   //    usage of it: https://isocpp.github.io/CppCoreGuidelines/CppCoreGuidelines#Res-goto
   //
@@ -375,14 +400,39 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
       auto value = m_LSP_mask.rlong(i);
 
 #if __cplusplus >= 202002L
+      // When the bitstream won't be exhausted by these 64 points, read all of their refinement
+      //    bits at once, mirroring the encoder.
+      const auto num_bits = std::popcount(value);
+      if (!Partial || read_pos + num_bits < m_avail_bits) {
+        auto bits = m_bit_buffer.rbits(num_bits);
+        read_pos += num_bits;
+        if (value == ~uint64_t{0}) {
+          for (size_t j = 0; j < 64; j++) {
+            const bool o1 = (bits >> j) & uint64_t{1};
+            m_coeff_buf[i + j] = o1 ? m_coeff_buf[i + j] + half_t : m_coeff_buf[i + j] - half_t;
+          }
+        }
+        else {
+          while (value) {
+            auto j = std::countr_zero(value);
+            if (bits & uint64_t{1})
+              m_coeff_buf[i + j] += half_t;
+            else
+              m_coeff_buf[i + j] -= half_t;
+            bits >>= 1;
+            value &= value - 1;
+          }
+        }
+        continue;
+      }
       while (value) {
         auto j = std::countr_zero(value);
         if (m_bit_buffer.rbit())
           m_coeff_buf[i + j] += half_t;
         else
           m_coeff_buf[i + j] -= half_t;
-        if (++read_pos == m_avail_bits)              // <-- Point 3
-          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
+        if (Partial && ++read_pos == m_avail_bits)  // <-- Point 3
+          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;   // <-- Point 4
         value &= value - 1;
       }
 #else
@@ -393,8 +443,8 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
               m_coeff_buf[i + j] += half_t;
             else
               m_coeff_buf[i + j] -= half_t;
-            if (++read_pos == m_avail_bits)              // <-- Point 3
-              goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
+            if (Partial && ++read_pos == m_avail_bits)  // <-- Point 3
+              goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;   // <-- Point 4
           }
         }
       }
@@ -406,8 +456,8 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
           m_coeff_buf[i] += half_t;
         else
           m_coeff_buf[i] -= half_t;
-        if (++read_pos == m_avail_bits)              // <-- Point 3
-          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;  // <-- Point 4
+        if (Partial && ++read_pos == m_avail_bits)  // <-- Point 3
+          goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;   // <-- Point 4
       }
     }
   }  // Finish the case where `m_threshold >= 2`.
@@ -416,11 +466,23 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
       auto value = m_LSP_mask.rlong(i);
 
 #if __cplusplus >= 202002L
+      const auto num_bits = std::popcount(value);
+      if (!Partial || read_pos + num_bits < m_avail_bits) {
+        auto bits = m_bit_buffer.rbits(num_bits);
+        read_pos += num_bits;
+        while (value) {
+          auto j = std::countr_zero(value);
+          m_coeff_buf[i + j] += uint_type(bits & uint64_t{1});
+          bits >>= 1;
+          value &= value - 1;
+        }
+        continue;
+      }
       while (value) {
         auto j = std::countr_zero(value);
         if (m_bit_buffer.rbit())
           ++(m_coeff_buf[i + j]);
-        if (++read_pos == m_avail_bits)
+        if (Partial && ++read_pos == m_avail_bits)
           goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
         value &= value - 1;
       }
@@ -429,7 +491,7 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
         if ((value >> j) & uint64_t{1}) {
           if (m_bit_buffer.rbit())
             ++(m_coeff_buf[i + j]);
-          if (++read_pos == m_avail_bits)
+          if (Partial && ++read_pos == m_avail_bits)
             goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
         }
       }
@@ -439,7 +501,7 @@ void sperr::SPECK_INT<T>::m_refinement_pass_decode()
       if (m_LSP_mask.rbit(i)) {
         if (m_bit_buffer.rbit())
           ++(m_coeff_buf[i]);
-        if (++read_pos == m_avail_bits)
+        if (Partial && ++read_pos == m_avail_bits)
           goto INITIALIZE_NEWLY_FOUND_POINTS_LABEL;
       }
     }
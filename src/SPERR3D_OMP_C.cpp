@@ -49,6 +49,26 @@ void sperr::SPERR3D_OMP_C::set_bitrate(double bpp)
   m_quality = bpp;
 }
 
+void sperr::SPERR3D_OMP_C::set_code_blocks(bool flag)
+{
+  m_code_blocks = flag;
+}
+
+void sperr::SPERR3D_OMP_C::enable_timing(bool flag)
+{
+  m_timing = flag;
+}
+
+auto sperr::SPERR3D_OMP_C::view_chunk_timing() const -> const std::vector<StageTimes>&
+{
+  return m_chunk_times;
+}
+
+auto sperr::SPERR3D_OMP_C::view_thread_timing() const -> const std::vector<StageTimes>&
+{
+  return m_thread_times;
+}
+
 #ifdef EXPERIMENTING
 void sperr::SPERR3D_OMP_C::set_direct_q(double q)
 {
@@ -60,6 +80,21 @@ void sperr::SPERR3D_OMP_C::set_direct_q(double q)
 
 template <typename T>
 auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
+{
+  if (m_mode == sperr::CompMode::Unknown)
+    return RTNType::CompModeUnknown;
+  if (buf_len != m_dims[0] * m_dims[1] * m_dims[2])
+    return RTNType::WrongLength;
+
+  const auto strides = std::array<size_t, 3>{1, m_dims[0], m_dims[0] * m_dims[1]};
+  return compress(buf, strides);
+}
+template auto sperr::SPERR3D_OMP_C::compress(const float*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const double*, size_t) -> RTNType;
+
+template <typename T>
+auto sperr::SPERR3D_OMP_C::compress(const T* base, std::array<size_t, 3> strides, size_t offset)
+    -> RTNType
 {
   static_assert(std::is_floating_point<T>::value, "!! Only floating point values are supported !!");
   if constexpr (std::is_same<T, float>::value)
@@ -69,8 +104,11 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
 
   if (m_mode == sperr::CompMode::Unknown)
     return RTNType::CompModeUnknown;
-  if (buf_len != m_dims[0] * m_dims[1] * m_dims[2])
-    return RTNType::WrongLength;
+  if (base == nullptr)
+    return RTNType::Error;
+  if (std::any_of(strides.cbegin(), strides.cend(), [](auto s) { return s == 0; }))
+    return RTNType::Error;
+  const auto* vol = base + offset;
 
   // First, calculate dimensions of individual chunk indices.
   const auto chunk_idx = sperr::chunk_volume(m_dims, m_chunk_dims);
@@ -81,26 +119,54 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
   m_encoded_streams.resize(num_chunks);
 
 #ifdef USE_OMP
+  // Chunks are distributed over threads. A volume of a single chunk instead gives all threads
+  //    to the wavelet transforms and code blocks within that chunk. The chunk loop then runs on
+  //    one thread, so the inner parallel regions are active without enabling nested parallelism.
+  const auto chunk_threads = std::min(m_num_threads, std::max(num_chunks, size_t{1}));
+  const auto xform_threads = chunk_threads == 1 ? m_num_threads : size_t{1};
+
+  // Chunks share a few distinct dimensions, so their wavelet transform plans are made once
+  //    and shared by all compressors.
+  const auto plans = sperr::make_dwt_plans(chunk_idx);
+
   m_compressors.resize(m_num_threads);
   for (auto& p : m_compressors) {
     if (p == nullptr)
       p = std::make_unique<SPECK3D_FLT>();
+    p->set_xform_threads(xform_threads);
+    p->set_code_blocks(m_code_blocks);
+    p->enable_timing(m_timing);
+    for (const auto& plan : plans)
+      p->use_dwt_plan(plan);
   }
 #else
+  const auto chunk_threads = size_t{1};
   if (m_compressor == nullptr)
     m_compressor = std::make_unique<SPECK3D_FLT>();
+  m_compressor->set_code_blocks(m_code_blocks);
+  m_compressor->enable_timing(m_timing);
+  for (const auto& plan : sperr::make_dwt_plans(chunk_idx))
+    m_compressor->use_dwt_plan(plan);
 #endif
 
-#pragma omp parallel for num_threads(m_num_threads)
+  m_chunk_times.assign(m_timing ? num_chunks : 0, StageTimes());
+  m_thread_times.assign(m_timing ? chunk_threads : 0, StageTimes());
+  auto chunk_bufs = std::vector<vecd_type>(chunk_threads);
+
+#pragma omp parallel for num_threads(chunk_threads)
   for (size_t i = 0; i < num_chunks; i++) {
 #ifdef USE_OMP
-    auto& compressor = m_compressors[omp_get_thread_num()];
+    const auto thread = size_t(omp_get_thread_num());
+    auto& compressor = m_compressors[thread];
 #else
+    const auto thread = size_t{0};
     auto& compressor = m_compressor;
 #endif
 
     // Gather data for this chunk, Setup compressor parameters, and compress!
-    auto chunk = m_gather_chunk<T>(buf, m_dims, chunk_idx[i]);
+    //    The compressor hands back its previous buffer, which the next chunk is gathered into.
+    auto& chunk = chunk_bufs[thread];
+    m_gather_chunk<T>(vol, m_dims, strides, chunk_idx[i], chunk);
     assert(!chunk.empty());
     compressor->take_data(std::move(chunk));
     compressor->set_dims({chunk_idx[i][1], chunk_idx[i][3], chunk_idx[i][5]});
@@ -122,6 +188,10 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
       default:;  // So the compiler doesn't complain about missing cases.
     }
     chunk_rtn[i] = compressor->compress();
+    if (m_timing) {
+      m_chunk_times[i] = compressor->view_timing();
+      m_thread_times[thread] += m_chunk_times[i];
+    }
 
     // Save bitstream for each chunk in `m_encoded_stream`.
     m_encoded_streams[i].clear();
@@ -139,8 +209,10 @@ auto sperr::SPERR3D_OMP_C::compress(const T* buf, size_t buf_len) -> RTNType
 
   return RTNType::Good;
 }
-template auto sperr::SPERR3D_OMP_C::compress(const float*, size_t) -> RTNType;
-template auto sperr::SPERR3D_OMP_C::compress(const double*, size_t) -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const float*, std::array<size_t, 3>, size_t)
+    -> RTNType;
+template auto sperr::SPERR3D_OMP_C::compress(const double*, std::array<size_t, 3>, size_t)
+    -> RTNType;
 
 auto sperr::SPERR3D_OMP_C::get_encoded_bitstream() const -> vec8_type
 {
@@ -234,34 +306,42 @@ auto sperr::SPERR3D_OMP_C::m_generate_header() const -> sperr::vec8_type
 }
 
 template <typename T>
-auto sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
+void sperr::SPERR3D_OMP_C::m_gather_chunk(const T* vol,
                                           dims_type vol_dim,
-                                          std::array<size_t, 6> chunk) -> vecd_type
+                                          std::array<size_t, 3> strides,
+                                          std::array<size_t, 6> chunk,
+                                          vecd_type& chunk_buf)
 {
-  auto chunk_buf = vecd_type();
+  chunk_buf.clear();
   if (chunk[0] + chunk[1] > vol_dim[0] || chunk[2] + chunk[3] > vol_dim[1] ||
       chunk[4] + chunk[5] > vol_dim[2])
-    return chunk_buf;
+    return;
 
   chunk_buf.resize(chunk[1] * chunk[3] * chunk[5]);
   const auto row_len = chunk[1];
 
   size_t idx = 0;
   for (size_t z = chunk[4]; z < chunk[4] + chunk[5]; z++) {
-    const size_t plane_offset = z * vol_dim[0] * vol_dim[1];
+    const size_t plane_offset = z * strides[2];
     for (size_t y = chunk[2]; y < chunk[2] + chunk[3]; y++) {
-      const auto start_i = plane_offset + y * vol_dim[0] + chunk[0];
-      std::copy(vol + start_i, vol + start_i + row_len, chunk_buf.begin() + idx);
+      const auto* row = vol + plane_offset + y * strides[1] + chunk[0] * strides[0];
+      if (strides[0] == 1)
+        std::copy(row, row + row_len, chunk_buf.begin() + idx);
+      else {
+        for (size_t x = 0; x < row_len; x++)
+          chunk_buf[idx + x] = row[x * strides[0]];
+      }
       idx += row_len;
     }
   }
-
-  // Will be subject to Named Return Value Optimization.
-  return chunk_buf;
 }
-template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const float*,
+template void sperr::SPERR3D_OMP_C::m_gather_chunk(const float*,
                                                    dims_type,
-                                                   std::array<size_t, 6>) -> vecd_type;
-template auto sperr::SPERR3D_OMP_C::m_gather_chunk(const double*,
+                                                   std::array<size_t, 3>,
+                                                   std::array<size_t, 6>,
+                                                   vecd_type&);
+template void sperr::SPERR3D_OMP_C::m_gather_chunk(const double*,
                                                    dims_type,
-                                                   std::array<size_t, 6>) -> vecd_type;
+                                                   std::array<size_t, 3>,
+                                                   std::array<size_t, 6>,
+                                                   vecd_type&);
@@ -20,6 +20,21 @@ void sperr::SPERR3D_OMP_D::set_num_threads(size_t n)
 #endif
 }
 
+void sperr::SPERR3D_OMP_D::enable_timing(bool flag)
+{
+  m_timing = flag;
+}
+
+auto sperr::SPERR3D_OMP_D::view_chunk_timing() const -> const std::vector<StageTimes>&
+{
+  return m_chunk_times;
+}
+
+auto sperr::SPERR3D_OMP_D::view_thread_timing() const -> const std::vector<StageTimes>&
+{
+  return m_thread_times;
+}
+
 auto sperr::SPERR3D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTNType
 {
   // This method gathers information from the header.
@@ -49,6 +64,52 @@ auto sperr::SPERR3D_OMP_D::use_bitstream(const void* p, size_t total_len) -> RTN
 }
 
 auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
+{
+  m_vol_buf.resize(m_dims[0] * m_dims[1] * m_dims[2]);
+  const auto strides = std::array<size_t, 3>{1, m_dims[0], m_dims[0] * m_dims[1]};
+  return m_decompress(p, m_vol_buf.data(), strides, multi_res);
+}
+
+template <typename T>
+auto sperr::SPERR3D_OMP_D::decompress(const void* p, T* dst, bool multi_res) -> RTNType
+{
+  const auto strides = std::array<size_t, 3>{1, m_dims[0], m_dims[0] * m_dims[1]};
+  return decompress(p, dst, strides, multi_res);
+}
+template auto sperr::SPERR3D_OMP_D::decompress(const void*, float*, bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress(const void*, double*, bool) -> RTNType;
+
+template <typename T>
+auto sperr::SPERR3D_OMP_D::decompress(const void* p,
+                                      T* dst,
+                                      std::array<size_t, 3> dst_strides,
+                                      bool multi_res) -> RTNType
+{
+  if (dst == nullptr)
+    return RTNType::Error;
+  if (std::any_of(dst_strides.cbegin(), dst_strides.cend(), [](auto s) { return s == 0; }))
+    return RTNType::Error;
+
+  // The internal volume isn't used, so don't keep the memory of a previous decompression.
+  m_vol_buf.clear();
+  m_vol_buf.shrink_to_fit();
+
+  return m_decompress(p, dst, dst_strides, multi_res);
+}
+template auto sperr::SPERR3D_OMP_D::decompress(const void*,
+                                               float*,
+                                               std::array<size_t, 3>,
+                                               bool) -> RTNType;
+template auto sperr::SPERR3D_OMP_D::decompress(const void*,
+                                               double*,
+                                               std::array<size_t, 3>,
+                                               bool) -> RTNType;
+
+template <typename T>
+auto sperr::SPERR3D_OMP_D::m_decompress(const void* p,
+                                        T* dst,
+                                        std::array<size_t, 3> dst_strides,
+                                        bool multi_res) -> RTNType
 {
   if (p == nullptr || m_bitstream_ptr == nullptr)
     return RTNType::Error;
@@ -62,10 +123,6 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
   // Let's figure out the chunk information
   const auto chunks = sperr::chunk_volume(m_dims, m_chunk_dims);
   const auto num_chunks = chunks.size();
-  const auto total_vals = m_dims[0] * m_dims[1] * m_dims[2];
-
-  // Allocate a buffer to store the entire volume
-  m_vol_buf.resize(total_vals);
 
   // A few variables to support multi-resolution decoding.
   const auto vol_res = sperr::coarsened_resolutions(m_dims, m_chunk_dims);
@@ -88,21 +145,44 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
   auto chunk_rtn = std::vector<RTNType>(num_chunks * 2, RTNType::Good);
 
 #ifdef USE_OMP
+  // Chunks are distributed over threads. A volume of a single chunk instead gives all threads
+  //    to the wavelet transforms within that chunk. The chunk loop then runs on one thread, so
+  //    the inner parallel regions are active without enabling nested parallelism.
+  const auto chunk_threads = std::min(m_num_threads, std::max(num_chunks, size_t{1}));
+  const auto xform_threads = chunk_threads == 1 ? m_num_threads : size_t{1};
+
+  // Chunks share a few distinct dimensions, so their wavelet transform plans are made once
+  //    and shared by all decompressors.
+  const auto plans = sperr::make_dwt_plans(chunks);
+
   m_decompressors.resize(m_num_threads);
-  std::for_each(m_decompressors.begin(), m_decompressors.end(), [](auto& p) {
+  std::for_each(m_decompressors.begin(), m_decompressors.end(), [&](auto& p) {
     if (p == nullptr)
       p = std::make_unique<SPECK3D_FLT>();
+    p->set_xform_threads(xform_threads);
+    p->enable_timing(m_timing);
+    for (const auto& plan : plans)
+      p->use_dwt_plan(plan);
   });
 #else
+  const auto chunk_threads = size_t{1};
   if (m_decompressor == nullptr)
     m_decompressor = std::make_unique<SPECK3D_FLT>();
+  m_decompressor->enable_timing(m_timing);
+  for (const auto& plan : sperr::make_dwt_plans(chunks))
+    m_decompressor->use_dwt_plan(plan);
 #endif
 
-#pragma omp parallel for num_threads(m_num_threads)
+  m_chunk_times.assign(m_timing ? num_chunks : 0, StageTimes());
+  m_thread_times.assign(m_timing ? chunk_threads : 0, StageTimes());
+
+#pragma omp parallel for num_threads(chunk_threads)
   for (size_t chunkI = 0; chunkI < num_chunks; chunkI++) {
 #ifdef USE_OMP
-    auto& decompressor = m_decompressors[omp_get_thread_num()];
+    const auto thread = size_t(omp_get_thread_num());
+    auto& decompressor = m_decompressors[thread];
 #else
+    const auto thread = size_t{0};
     auto& decompressor = m_decompressor;
 #endif
 
@@ -111,8 +191,12 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
     chunk_rtn[chunkI * 2] = decompressor->use_bitstream(m_bitstream_ptr + m_offsets[chunkI * 2],
                                                         m_offsets[chunkI * 2 + 1]);
     chunk_rtn[chunkI * 2 + 1] = decompressor->decompress(multi_res);
+    if (m_timing) {
+      m_chunk_times[chunkI] = decompressor->view_timing();
+      m_thread_times[thread] += m_chunk_times[chunkI];
+    }
     const auto& small_vol = decompressor->view_decoded_data();
-    m_scatter_chunk(m_vol_buf, m_dims, small_vol, chunks[chunkI]);
+    m_scatter_chunk(dst, dst_strides, small_vol, chunks[chunkI]);
 
     // Also assemble the full hierarchy.
     if (multi_res) {
@@ -121,7 +205,8 @@ auto sperr::SPERR3D_OMP_D::decompress(const void* p, bool multi_res) -> RTNType
       for (size_t h = 0; h < low_res.size(); h++) {
         const auto& small_dim = chunk_res[h];
         assert(low_res[h].size() == small_dim[0] * small_dim[1] * small_dim[2]);
-        m_scatter_chunk(m_hierarchy[h], vol_res[h], low_res[h], hierarchy_chunks[h][chunkI]);
+        const auto strides = std::array<size_t, 3>{1, vol_res[h][0], vol_res[h][0] * vol_res[h][1]};
+        m_scatter_chunk(m_hierarchy[h].data(), strides, low_res[h], hierarchy_chunks[h][chunkI]);
       }
     }
   }  // End of OMP parallel section.
@@ -164,8 +249,9 @@ auto sperr::SPERR3D_OMP_D::get_chunk_dims() const -> std::array<size_t, 3>
   return m_chunk_dims;
 }
 
-void sperr::SPERR3D_OMP_D::m_scatter_chunk(vecd_type& big_vol,
-                                           dims_type vol_dim,
+template <typename T>
+void sperr::SPERR3D_OMP_D::m_scatter_chunk(T* big_vol,
+                                           std::array<size_t, 3> strides,
                                            const vecd_type& small_vol,
                                            std::array<size_t, 6> chunk_info)
 {
@@ -173,11 +259,15 @@ void sperr::SPERR3D_OMP_D::m_scatter_chunk(vecd_type& big_vol,
   const auto row_len = chunk_info[1];
 
   for (size_t z = chunk_info[4]; z < chunk_info[4] + chunk_info[5]; z++) {
-    const size_t plane_offset = z * vol_dim[0] * vol_dim[1];
+    const size_t plane_offset = z * strides[2];
     for (size_t y = chunk_info[2]; y < chunk_info[2] + chunk_info[3]; y++) {
-      const auto start_i = plane_offset + y * vol_dim[0] + chunk_info[0];
-      std::copy(small_vol.begin() + idx, small_vol.begin() + idx + row_len,
-                big_vol.begin() + start_i);
+      auto* row = big_vol + plane_offset + y * strides[1] + chunk_info[0] * strides[0];
+      if (strides[0] == 1)
+        std::copy(small_vol.begin() + idx, small_vol.begin() + idx + row_len, row);
+      else {
+        for (size_t x = 0; x < row_len; x++)
+          row[x * strides[0]] = small_vol[idx + x];
+      }
       idx += row_len;
     }
   }
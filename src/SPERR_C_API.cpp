@@ -228,31 +228,32 @@ auto C_API::sperr_decomp_3d(const void* src,
   if (*dst != nullptr)
     return 1;
 
-  // Use a decompressor to decompress this bitstream
+  // Use a decompressor to decompress this bitstream, straight into the output buffer.
   auto decoder = std::make_unique<sperr::SPERR3D_OMP_D>();
   decoder->set_num_threads(nthreads);
   decoder->use_bitstream(src, src_len);
-  auto rtn = decoder->decompress(src);
-  if (rtn != sperr::RTNType::Good)
+  const auto dims = decoder->get_dims();
+  const auto total_vals = dims[0] * dims[1] * dims[2];
+  void* buf = nullptr;
+  auto rtn = sperr::RTNType::Good;
+  if (output_float) {
+    buf = std::malloc(total_vals * sizeof(float));
+    rtn = decoder->decompress(src, static_cast<float*>(buf));
+  }
+  else {  // double
+    buf = std::malloc(total_vals * sizeof(double));
+    rtn = decoder->decompress(src, static_cast<double*>(buf));
+  }
+  if (rtn != sperr::RTNType::Good) {
+    std::free(buf);
     return -1;
-  auto dims = decoder->get_dims();
-  auto outputd = decoder->release_decoded_data();
-  decoder.reset();
+  }
 
   // Provide the decompressed volume.
   *dimx = dims[0];
   *dimy = dims[1];
   *dimz = dims[2];
-  if (output_float) {
-    auto* buf = (float*)std::malloc(outputd.size() * sizeof(float));
-    std::copy(outputd.cbegin(), outputd.cend(), buf);
-    *dst = buf;
-  }
-  else {  // double
-    auto* buf = (double*)std::malloc(outputd.size() * sizeof(double));
-    std::copy(outputd.cbegin(), outputd.cend(), buf);
-    *dst = buf;
-  }
+  *dst = buf;
 
   return 0;
 }
@@ -11,6 +11,76 @@
 #include <omp.h>
 #endif
 
+auto sperr::isa_supported(ISAType isa) -> bool
+{
+  switch (isa) {
+    case ISAType::Scalar:
+      return true;
+#ifdef USE_SIMD
+    case ISAType::AVX2:
+      return __builtin_cpu_supports("avx2");
+    case ISAType::AVX512:
+      return __builtin_cpu_supports("avx512f");
+#endif
+    default:
+      return false;
+  }
+}
+
+auto sperr::best_isa() -> ISAType
+{
+  // Querying the CPU isn't free, so only do it once.
+  static const auto best = []() {
+    if (sperr::isa_supported(ISAType::AVX512))
+      return ISAType::AVX512;
+    else if (sperr::isa_supported(ISAType::AVX2))
+      return ISAType::AVX2;
+    else
+      return ISAType::Scalar;
+  }();
+  return best;
+}
+
+void sperr::StageTimes::record(StageType stage, double sec, size_t num_bytes)
+{
+  seconds[size_t(stage)] += sec;
+  bytes[size_t(stage)] += num_bytes;
+}
+
+auto sperr::StageTimes::total_seconds() const -> double
+{
+  return std::accumulate(seconds.cbegin(), seconds.cend(), 0.0);
+}
+
+auto sperr::StageTimes::operator+=(const StageTimes& other) -> StageTimes&
+{
+  for (size_t i = 0; i < seconds.size(); i++) {
+    seconds[i] += other.seconds[i];
+    bytes[i] += other.bytes[i];
+  }
+  rate_predicted += other.rate_predicted;
+  rate_retried += other.rate_retried;
+  return *this;
+}
+
+auto sperr::stage_name(StageType stage) -> const char*
+{
+  switch (stage) {
+    case StageType::Condition:
+      return "condition";
+    case StageType::Xform:
+      return "wavelet";
+    case StageType::Quantize:
+      return "quantize";
+    case StageType::Outlier:
+      return "outlier";
+    case StageType::Speck:
+      return "speck";
+    default:
+      return "unknown";
+  }
+}
+
 auto sperr::num_of_xforms(size_t len) -> size_t
 {
   assert(len > 0);
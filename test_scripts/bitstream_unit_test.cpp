@@ -111,6 +111,51 @@ TEST(Bitstream, StreamWriteRead)
     EXPECT_EQ(s1.rbit(), vec[i]) << " at idx = " << i;
 }
 
+TEST(Bitstream, MultiBitWriteRead)
+{
+  // Write chunks of random lengths (0 to 64 bits) with wbits(), mixed with single bits, and
+  //    read them back bit by bit and chunk by chunk.
+  std::mt19937 gen(17);
+  std::uniform_int_distribution<size_t> distrib1(0, 64);
+  auto s1 = Stream();
+  auto vec = std::vector<bool>();
+  auto lens = std::vector<size_t>();
+  for (size_t i = 0; i < 300; i++) {
+    const auto nbits = distrib1(gen);
+    auto bits = (uint64_t{gen()} << 32) | gen();
+    if (nbits < 64)
+      bits &= (uint64_t{1} << nbits) - 1;
+    s1.wbits(bits, nbits);
+    lens.push_back(nbits);
+    for (size_t j = 0; j < nbits; j++)
+      vec.push_back((bits >> j) & uint64_t{1});
+    if (i % 3 == 0) {
+      s1.wbit(true);
+      lens.push_back(1);
+      vec.push_back(true);
+    }
+  }
+  EXPECT_EQ(s1.wtell(), vec.size());
+  s1.flush();
+
+  s1.rewind();
+  for (size_t i = 0; i < vec.size(); i++)
+    EXPECT_EQ(s1.rbit(), vec[i]) << " at idx = " << i;
+
+  s1.rewind();
+  size_t pos = 0;
+  for (auto nbits : lens) {
+    const auto bits = s1.rbits(nbits);
+    for (size_t j = 0; j < nbits; j++)
+      EXPECT_EQ((bits >> j) & uint64_t{1}, vec[pos + j]) << " at idx = " << pos + j;
+    if (nbits < 64) {
+      EXPECT_EQ(bits >> nbits, 0);
+    }
+    pos += nbits;
+    EXPECT_EQ(s1.rtell(), pos);
+  }
+}
+
 TEST(Bitstream, RandomWriteRead)
 {
   const size_t N = 256;
@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <cstdlib>
 #include "CDF97.h"
+#include "CDF97_Stream.h"
 #include "Conditioner.h"
 #include "gtest/gtest.h"
 
@@ -24,7 +26,7 @@ TEST(dwt1d, big_image_even)
   auto meta = condi.condition(in_copy, {dim_x, 1, 1});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, 1, 1});
   cdf.dwt1d();
   cdf.idwt1d();
@@ -60,7 +62,7 @@ TEST(dwt1d, big_image_odd)
   auto meta = condi.condition(in_copy, {dim_x, 1, 1});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, 1, 1});
   cdf.dwt1d();
   cdf.idwt1d();
@@ -95,7 +97,7 @@ TEST(dwt2d, small_image_even)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, 1});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, 1});
   cdf.dwt2d();
   cdf.idwt2d();
@@ -130,7 +132,7 @@ TEST(dwt2d, small_image_odd)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, 1});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, 1});
   cdf.dwt2d();
   cdf.idwt2d();
@@ -165,7 +167,7 @@ TEST(dwt2d, big_image_even)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, 1});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, 1});
   cdf.dwt2d();
   cdf.idwt2d();
@@ -200,7 +202,7 @@ TEST(dwt2d, big_image_odd)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, 1});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, 1});
   cdf.dwt2d();
   cdf.idwt2d();
@@ -235,7 +237,7 @@ TEST(dwt2d, image_multi_res)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, 1});
 
   // Use a sperr::CDF97 to perform DWT and multi-res IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, 1});
   cdf.dwt2d();
   auto hierarchy = cdf.idwt2d_multi_res();
@@ -277,7 +279,7 @@ TEST(dwt3d, small_even_cube)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, dim_z});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, dim_z});
   cdf.dwt3d();
   cdf.idwt3d();
@@ -311,7 +313,7 @@ TEST(dwt3d, big_odd_cube)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, dim_z});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, dim_z});
   cdf.dwt3d();
   cdf.idwt3d();
@@ -345,7 +347,7 @@ TEST(dwt3d, big_even_cube)
   auto meta = condi.condition(in_copy, {dim_x, dim_y, dim_z});
 
   // Use a sperr::CDF97 to perform DWT and IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), {dim_x, dim_y, dim_z});
   cdf.dwt3d();
   cdf.idwt3d();
@@ -379,7 +381,7 @@ TEST(dwt3d, multi_res)
   auto meta = condi.condition(in_copy, dims);
 
   // Use a sperr::CDF97 to perform DWT and multi-res IDWT.
-  sperr::CDF97 cdf;
+  sperr::CDF97<double> cdf;
   cdf.take_data(std::move(in_copy), dims);
   cdf.dwt3d();
   auto hierarchy = std::vector<sperr::vecd_type>();
@@ -404,4 +406,496 @@ TEST(dwt3d, multi_res)
   }
 }
 
+TEST(dwt3d, single_precision)
+{
+  auto in_buf = sperr::read_whole_file<float>("../test_data/wmag91.float");
+  ASSERT_EQ(in_buf.size(), 91 * 91 * 91);
+  auto [min, max] = std::minmax_element(in_buf.cbegin(), in_buf.cend());
+  const auto range = double(*max) - double(*min);
+
+  // Transforms in single precision should be close to those in double precision, and
+  //    recover the input up to single-precision round-off.
+  auto cdf_d = sperr::CDF97<double>();
+  cdf_d.copy_data(in_buf.data(), in_buf.size(), {91, 91, 91});
+  cdf_d.dwt3d();
+  auto cdf_f = sperr::CDF97<float>();
+  cdf_f.copy_data(in_buf.data(), in_buf.size(), {91, 91, 91});
+  cdf_f.dwt3d();
+  const auto& coeffs_d = cdf_d.view_data();
+  const auto& coeffs_f = cdf_f.view_data();
+  for (size_t i = 0; i < in_buf.size(); i++)
+    ASSERT_NEAR(coeffs_d[i], coeffs_f[i], range * 1e-4) << "i = " << i;
+
+  cdf_f.idwt3d();
+  const auto& result = cdf_f.view_data();
+  for (size_t i = 0; i < in_buf.size(); i++)
+    ASSERT_NEAR(in_buf[i], result[i], range * 1e-6) << "i = " << i;
+}
+
+//
+// Lifting kernels written for every instruction set should produce bit-identical results.
+//
+template <typename T>
+void compare_isa(const sperr::vecd_type& input, sperr::dims_type dims)
+{
+  const auto isas = {sperr::ISAType::AVX2, sperr::ISAType::AVX512};
+
+  auto run = [&](sperr::ISAType isa, bool forward) {
+    auto cdf = sperr::CDF97<T>();
+    EXPECT_EQ(cdf.set_isa(isa), sperr::RTNType::Good);
+    cdf.copy_data(input.data(), input.size(), dims);
+    if (dims[1] == 1 && dims[2] == 1)
+      forward ? cdf.dwt1d() : cdf.idwt1d();
+    else if (dims[2] == 1)
+      forward ? cdf.dwt2d() : cdf.idwt2d();
+    else
+      forward ? cdf.dwt3d() : cdf.idwt3d();
+    return cdf.release_data();
+  };
+
+  const auto fwd = run(sperr::ISAType::Scalar, true);
+  const auto inv = run(sperr::ISAType::Scalar, false);
+  for (auto isa : isas) {
+    if (!sperr::isa_supported(isa)) {
+      auto cdf = sperr::CDF97<T>();
+      EXPECT_EQ(cdf.set_isa(isa), sperr::RTNType::Error);
+      continue;
+    }
+    EXPECT_EQ(run(isa, true), fwd) << "ISA = " << int(isa);
+    EXPECT_EQ(run(isa, false), inv) << "ISA = " << int(isa);
+  }
+}
+
+TEST(dwt_isa, one_dim)
+{
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  ASSERT_EQ(in_buf.size(), 512 * 512);
+  auto input = sperr::vecd_type(in_buf.begin(), in_buf.end());
+
+  for (size_t len : {8, 9, 17, 30, 31, 100, 255, 512, 1023, 4096, 4099}) {
+    auto sub = sperr::vecd_type(input.begin(), input.begin() + len);
+    compare_isa<double>(sub, {len, 1, 1});
+    compare_isa<float>(sub, {len, 1, 1});
+  }
+}
+
+TEST(dwt_isa, two_dim)
+{
+  auto in_buf = sperr::read_whole_file<float>("../test_data/lena512.float");
+  ASSERT_EQ(in_buf.size(), 512 * 512);
+  compare_isa<double>({in_buf.begin(), in_buf.end()}, {512, 512, 1});
+  compare_isa<float>({in_buf.begin(), in_buf.end()}, {512, 512, 1});
+  compare_isa<double>({in_buf.begin(), in_buf.begin() + 999 * 131}, {999, 131, 1});
+  compare_isa<float>({in_buf.begin(), in_buf.begin() + 999 * 131}, {999, 131, 1});
+}
+
+TEST(dwt_isa, three_dim)
+{
+  // Dyadic transform
+  auto in_buf = sperr::read_whole_file<float>("../test_data/wmag91.float");
+  ASSERT_EQ(in_buf.size(), 91 * 91 * 91);
+  compare_isa<double>({in_buf.begin(), in_buf.end()}, {91, 91, 91});
+  compare_isa<float>({in_buf.begin(), in_buf.end()}, {91, 91, 91});
+
+  // Wavelet packet transform
+  in_buf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(in_buf.size(), 128 * 128 * 41);
+  compare_isa<double>({in_buf.begin(), in_buf.end()}, {128, 128, 41});
+  compare_isa<float>({in_buf.begin(), in_buf.end()}, {128, 128, 41});
+}
+
+// A scalar reference of the transforms as they were before the lifting steps were fused:
+//    the QccPack functions lift a signal in four sweeps over interleaved samples, and the
+//    low-pass and high-pass samples are then gathered into two halves (scattered back before
+//    the synthesis).
+class QccReference {
+ public:
+  void dwt1d(double* p, size_t len) const
+  {
+    for (size_t lev = 0; lev < sperr::num_of_xforms(len); lev++)
+      m_analysis(p, sperr::calc_approx_detail_len(len, lev)[0], 1);
+  }
+
+  void idwt1d(double* p, size_t len) const
+  {
+    for (size_t lev = sperr::num_of_xforms(len); lev > 0; lev--)
+      m_synthesis(p, sperr::calc_approx_detail_len(len, lev - 1)[0], 1);
+  }
+
+  void dwt2d(double* p, std::array<size_t, 2> len_xy) const
+  {
+    for (size_t lev = 0; lev < sperr::num_of_xforms(std::min(len_xy[0], len_xy[1])); lev++) {
+      const auto x = sperr::calc_approx_detail_len(len_xy[0], lev)[0];
+      const auto y = sperr::calc_approx_detail_len(len_xy[1], lev)[0];
+      for (size_t i = 0; i < y; i++)
+        m_analysis(p + i * len_xy[0], x, 1);
+      for (size_t i = 0; i < x; i++)
+        m_analysis(p + i, y, len_xy[0]);
+    }
+  }
+
+  void idwt2d(double* p, std::array<size_t, 2> len_xy) const
+  {
+    for (size_t lev = sperr::num_of_xforms(std::min(len_xy[0], len_xy[1])); lev > 0; lev--) {
+      const auto x = sperr::calc_approx_detail_len(len_xy[0], lev - 1)[0];
+      const auto y = sperr::calc_approx_detail_len(len_xy[1], lev - 1)[0];
+      for (size_t i = 0; i < x; i++)
+        m_synthesis(p + i, y, len_xy[0]);
+      for (size_t i = 0; i < y; i++)
+        m_synthesis(p + i * len_xy[0], x, 1);
+    }
+  }
+
+ private:
+  const std::array<double, 5> h = {0.602949018236, 0.266864118443, -0.078223266529,
+                                   -0.016864118443, 0.026748757411};
+  const double r0 = h[0] - 2.0 * h[4] * h[1] / h[3];
+  const double r1 = h[2] - h[4] - h[4] * h[1] / h[3];
+  const double s0 = h[1] - h[3] - h[3] * r0 / r1;
+  const double t0 = h[0] - 2.0 * (h[2] - h[4]);
+  const double ALPHA = h[4] / h[3];
+  const double BETA = h[3] / r1;
+  const double GAMMA = r1 / s0;
+  const double DELTA = s0 / t0;
+  const double EPSILON = std::sqrt(2.0) * t0;
+  const double INV_EPSILON = 1.0 / (std::sqrt(2.0) * t0);
+
+  // One level on `len` samples that are `stride` apart: lift, then gather the even samples
+  //    into the first half and the odd samples into the second half.
+  void m_analysis(double* p, size_t len, size_t stride) const
+  {
+    auto buf = std::vector<double>(len);
+    for (size_t i = 0; i < len; i++)
+      buf[i] = p[i * stride];
+    if (len % 2 == 0)
+      m_analysis_even_even(buf.data(), len);
+    else
+      m_analysis_odd_even(buf.data(), len);
+    const auto low = len - len / 2;
+    for (size_t i = 0; i < low; i++)
+      p[i * stride] = buf[i * 2];
+    for (size_t i = 0; i < len / 2; i++)
+      p[(low + i) * stride] = buf[i * 2 + 1];
+  }
+
+  void m_synthesis(double* p, size_t len, size_t stride) const
+  {
+    auto buf = std::vector<double>(len);
+    const auto low = len - len / 2;
+    for (size_t i = 0; i < low; i++)
+      buf[i * 2] = p[i * stride];
+    for (size_t i = 0; i < len / 2; i++)
+      buf[i * 2 + 1] = p[(low + i) * stride];
+    if (len % 2 == 0)
+      m_synthesis_even_even(buf.data(), len);
+    else
+      m_synthesis_odd_even(buf.data(), len);
+    for (size_t i = 0; i < len; i++)
+      p[i * stride] = buf[i];
+  }
+
+  void m_analysis_even_even(double* signal, size_t signal_length) const
+  {
+    for (size_t i = 1; i < signal_length - 2; i += 2)
+      signal[i] += ALPHA * (signal[i - 1] + signal[i + 1]);
+    signal[signal_length - 1] += 2.0 * ALPHA * signal[signal_length - 2];
+    signal[0] += 2.0 * BETA * signal[1];
+    for (size_t i = 2; i < signal_length; i += 2)
+      signal[i] += BETA * (signal[i + 1] + signal[i - 1]);
+    for (size_t i = 1; i < signal_length - 2; i += 2)
+      signal[i] += GAMMA * (signal[i - 1] + signal[i + 1]);
+    signal[signal_length - 1] += 2.0 * GAMMA * signal[signal_length - 2];
+    signal[0] = EPSILON * (signal[0] + 2.0 * DELTA * signal[1]);
+    for (size_t i = 2; i < signal_length; i += 2)
+      signal[i] = EPSILON * (signal[i] + DELTA * (signal[i + 1] + signal[i - 1]));
+    for (size_t i = 1; i < signal_length; i += 2)
+      signal[i] *= -INV_EPSILON;
+  }
+
+  void m_analysis_odd_even(double* signal, size_t signal_length) const
+  {
+    for (size_t i = 1; i < signal_length - 1; i += 2)
+      signal[i] += ALPHA * (signal[i - 1] + signal[i + 1]);
+    signal[0] += 2.0 * BETA * signal[1];
+    for (size_t i = 2; i < signal_length - 2; i += 2)
+      signal[i] += BETA * (signal[i + 1] + signal[i - 1]);
+    signal[signal_length - 1] += 2.0 * BETA * signal[signal_length - 2];
+    for (size_t i = 1; i < signal_length - 1; i += 2)
+      signal[i] += GAMMA * (signal[i - 1] + signal[i + 1]);
+    signal[0] = EPSILON * (signal[0] + 2.0 * DELTA * signal[1]);
+    for (size_t i = 2; i < signal_length - 2; i += 2)
+      signal[i] = EPSILON * (signal[i] + DELTA * (signal[i + 1] + signal[i - 1]));
+    signal[signal_length - 1] =
+        EPSILON * (signal[signal_length - 1] + 2.0 * DELTA * signal[signal_length - 2]);
+    for (size_t i = 1; i < signal_length - 1; i += 2)
+      signal[i] *= (-INV_EPSILON);
+  }
+
+  void m_synthesis_even_even(double* signal, size_t signal_length) const
+  {
+    for (size_t i = 1; i < signal_length; i += 2)
+      signal[i] *= (-EPSILON);
+    signal[0] = signal[0] * INV_EPSILON - 2.0 * DELTA * signal[1];
+    for (size_t i = 2; i < signal_length; i += 2)
+      signal[i] = signal[i] * INV_EPSILON - DELTA * (signal[i + 1] + signal[i - 1]);
+    for (size_t i = 1; i < signal_length - 2; i += 2)
+      signal[i] -= GAMMA * (signal[i - 1] + signal[i + 1]);
+    signal[signal_length - 1] -= 2.0 * GAMMA * signal[signal_length - 2];
+    signal[0] -= 2.0 * BETA * signal[1];
+    for (size_t i = 2; i < signal_length; i += 2)
+      signal[i] -= BETA * (signal[i + 1] + signal[i - 1]);
+    for (size_t i = 1; i < signal_length - 2; i += 2)
+      signal[i] -= ALPHA * (signal[i - 1] + signal[i + 1]);
+    signal[signal_length - 1] -= 2.0 * ALPHA * signal[signal_length - 2];
+  }
+
+  void m_synthesis_odd_even(double* signal, size_t signal_length) const
+  {
+    for (size_t i = 1; i < signal_length - 1; i += 2)
+      signal[i] *= (-EPSILON);
+    signal[0] = signal[0] * INV_EPSILON - 2.0 * DELTA * signal[1];
+    for (size_t i = 2; i < signal_length - 2; i += 2)
+      signal[i] = signal[i] * INV_EPSILON - DELTA * (signal[i + 1] + signal[i - 1]);
+    signal[signal_length - 1] =
+        signal[signal_length - 1] * INV_EPSILON - 2.0 * DELTA * signal[signal_length - 2];
+    for (size_t i = 1; i < signal_length - 1; i += 2)
+      signal[i] -= GAMMA * (signal[i - 1] + signal[i + 1]);
+    signal[0] -= 2.0 * BETA * signal[1];
+    for (size_t i = 2; i < signal_length - 2; i += 2)
+      signal[i] -= BETA * (signal[i + 1] + signal[i - 1]);
+    signal[signal_length - 1] -= 2.0 * BETA * signal[signal_length - 2];
+    for (size_t i = 1; i < signal_length - 1; i += 2)
+      signal[i] -= ALPHA * (signal[i - 1] + signal[i + 1]);
+  }
+};
+
+TEST(dwt_fused, qcc_reference)
+{
+  // The fused lifting kernels should produce bit-identical results as the QccPack functions.
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.512_512");
+  ASSERT_EQ(in_buf.size(), 512 * 512);
+  const auto input = sperr::vecd_type(in_buf.begin(), in_buf.end());
+  const auto ref = QccReference();
+
+  for (size_t len : {9, 10, 11, 12, 13, 16, 17, 18, 31, 64, 127, 255, 512, 1023, 4096, 4099}) {
+    auto expected = sperr::vecd_type(input.begin(), input.begin() + len);
+    ref.dwt1d(expected.data(), len);
+    auto cdf = sperr::CDF97<double>();
+    ASSERT_EQ(cdf.copy_data(input.data(), len, {len, 1, 1}), sperr::RTNType::Good);
+    cdf.dwt1d();
+    EXPECT_EQ(cdf.view_data(), expected) << "len = " << len;
+
+    ref.idwt1d(expected.data(), len);
+    cdf.idwt1d();
+    EXPECT_EQ(cdf.view_data(), expected) << "len = " << len;
+  }
+
+  // Planes, where the columns go through the lane kernels.
+  for (auto len_xy : {std::array<size_t, 2>{9, 10}, {10, 9}, {11, 13}, {64, 64}, {127, 129}}) {
+    const auto total = len_xy[0] * len_xy[1];
+    auto expected = sperr::vecd_type(input.begin(), input.begin() + total);
+    ref.dwt2d(expected.data(), len_xy);
+    auto cdf = sperr::CDF97<double>();
+    ASSERT_EQ(cdf.copy_data(input.data(), total, {len_xy[0], len_xy[1], 1}),
+              sperr::RTNType::Good);
+    cdf.dwt2d();
+    EXPECT_EQ(cdf.view_data(), expected) << len_xy[0] << " x " << len_xy[1];
+
+    ref.idwt2d(expected.data(), len_xy);
+    cdf.idwt2d();
+    EXPECT_EQ(cdf.view_data(), expected) << len_xy[0] << " x " << len_xy[1];
+  }
+}
+
+TEST(dwt3d, z_tile)
+{
+  // The size of Z column tiles shouldn't affect the results.
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(in_buf.size(), 128 * 128 * 41);
+
+  // Both the dyadic (81, 83, 97) and the wavelet packet (128, 128, 41) transforms.
+  for (auto dims : {sperr::dims_type{81, 83, 97}, sperr::dims_type{128, 128, 41}}) {
+    const auto total = dims[0] * dims[1] * dims[2];
+    auto cdf = sperr::CDF97<double>();
+    ASSERT_EQ(cdf.copy_data(in_buf.data(), total, dims), sperr::RTNType::Good);
+    cdf.dwt3d();
+    const auto fwd = cdf.view_data();
+    cdf.idwt3d();
+    const auto inv = cdf.view_data();
+
+    for (auto tile : {std::array<size_t, 2>{1, 1}, {7, 3}, {32, 2}, {128, 128}, {200, 1}}) {
+      cdf.set_z_tile(tile);
+      ASSERT_EQ(cdf.copy_data(in_buf.data(), total, dims), sperr::RTNType::Good);
+      cdf.dwt3d();
+      EXPECT_EQ(cdf.view_data(), fwd) << tile[0] << " x " << tile[1];
+      cdf.idwt3d();
+      EXPECT_EQ(cdf.view_data(), inv) << tile[0] << " x " << tile[1];
+    }
+  }
+}
+
+TEST(dwt3d, num_threads)
+{
+  // The number of threads shouldn't affect the results.
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(in_buf.size(), 128 * 128 * 41);
+
+  // Both the dyadic (81, 83, 97) and the wavelet packet (128, 128, 41) transforms.
+  for (auto dims : {sperr::dims_type{81, 83, 97}, sperr::dims_type{128, 128, 41}}) {
+    const auto total = dims[0] * dims[1] * dims[2];
+    auto cdf = sperr::CDF97<double>();
+    ASSERT_EQ(cdf.copy_data(in_buf.data(), total, dims), sperr::RTNType::Good);
+    cdf.dwt3d();
+    const auto fwd = cdf.view_data();
+    cdf.idwt3d();
+    const auto inv = cdf.view_data();
+
+    for (size_t n : {2, 3, 0}) {
+      cdf.set_num_threads(n);
+      ASSERT_EQ(cdf.copy_data(in_buf.data(), total, dims), sperr::RTNType::Good);
+      cdf.dwt3d();
+      EXPECT_EQ(cdf.view_data(), fwd) << n << " threads";
+      cdf.idwt3d();
+      EXPECT_EQ(cdf.view_data(), inv) << n << " threads";
+    }
+  }
+
+  // A 2D slice, which is transformed row by row and column by column.
+  auto cdf = sperr::CDF97<double>();
+  ASSERT_EQ(cdf.copy_data(in_buf.data(), 128 * 127, {128, 127, 1}), sperr::RTNType::Good);
+  cdf.dwt2d();
+  const auto fwd = cdf.view_data();
+  cdf.idwt2d();
+  const auto inv = cdf.view_data();
+
+  cdf.set_num_threads(4);
+  ASSERT_EQ(cdf.copy_data(in_buf.data(), 128 * 127, {128, 127, 1}), sperr::RTNType::Good);
+  cdf.dwt2d();
+  EXPECT_EQ(cdf.view_data(), fwd);
+  cdf.idwt2d();
+  EXPECT_EQ(cdf.view_data(), inv);
+}
+
+TEST(dwt3d, region)
+{
+  // A region reconstructed alone should be identical to the same region of a full inverse.
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(in_buf.size(), 128 * 128 * 41);
+
+  // Both the dyadic (80, 80, 100), (81, 83, 97) and the wavelet packet (128, 128, 41),
+  //    (127, 129, 41) transforms.
+  for (auto dims : {sperr::dims_type{80, 80, 100}, sperr::dims_type{81, 83, 97},
+                    sperr::dims_type{128, 128, 41}, sperr::dims_type{127, 129, 41}}) {
+    const auto total = dims[0] * dims[1] * dims[2];
+    auto cdf = sperr::CDF97<double>();
+    cdf.copy_data(in_buf.data(), total, dims);
+    cdf.dwt3d();
+    auto full = sperr::CDF97<double>();
+    full.copy_data(cdf.view_data().data(), total, dims);
+    full.idwt3d();
+    const auto& inv = full.view_data();
+
+    const auto boxes = std::vector<std::array<size_t, 6>>{
+        {0, dims[0], 0, dims[1], 0, dims[2]}, {0, 1, 0, 1, 0, 1},
+        {dims[0] - 1, 1, dims[1] - 1, 1, dims[2] - 1, 1},
+        {5, 20, 30, 17, 9, 11}, {10, 1, 60, 9, 0, dims[2]},
+        {0, 16, dims[1] - 33, 33, 20, 5}, {dims[0] - 30, 30, 7, 64, 3, 2}};
+    for (const auto& box : boxes) {
+      const auto region = cdf.idwt3d_region(box);
+      ASSERT_EQ(region.size(), box[1] * box[3] * box[5]);
+      auto expected = sperr::vecd_type();
+      for (size_t z = box[4]; z < box[4] + box[5]; z++) {
+        for (size_t y = box[2]; y < box[2] + box[3]; y++) {
+          const auto row = inv.begin() + (z * dims[1] + y) * dims[0] + box[0];
+          expected.insert(expected.end(), row, row + box[1]);
+        }
+      }
+      EXPECT_EQ(region, expected) << box[0] << ", " << box[2] << ", " << box[4];
+    }
+
+    // Invalid boxes
+    EXPECT_TRUE(cdf.idwt3d_region({0, 0, 0, 1, 0, 1}).empty());
+    EXPECT_TRUE(cdf.idwt3d_region({1, dims[0], 0, 1, 0, 1}).empty());
+    EXPECT_TRUE(cdf.idwt3d_region({0, 1, 0, 1, dims[2], 1}).empty());
+  }
+}
+
+TEST(dwt3d, plan)
+{
+  // Chunks of a 128x128x41 volume come in 4 distinct dimensions.
+  const auto chunks = sperr::chunk_volume({128, 128, 41}, {50, 50, 41});
+  const auto plans = sperr::make_dwt_plans(chunks);
+  ASSERT_EQ(plans.size(), 4);
+  for (const auto& p : plans) {
+    EXPECT_EQ(p->dyadic, sperr::can_use_dyadic(p->dims));
+    EXPECT_EQ(p->xforms_xy, sperr::num_of_xforms(std::min(p->dims[0], p->dims[1])));
+    EXPECT_EQ(p->xforms_z, sperr::num_of_xforms(p->dims[2]));
+    EXPECT_EQ(p->approx[0], p->dims);
+  }
+
+  // A shared plan produces the same results as one made by the CDF97 object itself.
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(in_buf.size(), 128 * 128 * 41);
+  for (auto dims : {sperr::dims_type{81, 83, 97}, sperr::dims_type{128, 128, 41}}) {
+    const auto total = dims[0] * dims[1] * dims[2];
+    auto cdf = sperr::CDF97<double>();
+    cdf.copy_data(in_buf.data(), total, dims);
+    cdf.dwt3d();
+    const auto fwd = cdf.view_data();
+
+    auto shared = sperr::CDF97<double>();
+    shared.use_plan(sperr::make_dwt_plan(dims));
+    shared.copy_data(in_buf.data(), 100, {10, 10, 1});
+    shared.dwt2d();
+    shared.copy_data(in_buf.data(), total, dims);
+    shared.dwt3d();
+    EXPECT_EQ(shared.view_data(), fwd);
+  }
+}
+
+TEST(dwt3d, stream)
+{
+  // Slabs should make up the same coefficients, each one of them written exactly once.
+  auto in_buf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  ASSERT_EQ(in_buf.size(), 128 * 128 * 41);
+
+  // Dyadic, wavelet packet, and no Z transform at all.
+  for (auto dims : {sperr::dims_type{81, 83, 97}, sperr::dims_type{64, 64, 150},
+                    sperr::dims_type{128, 128, 41}, sperr::dims_type{127, 129, 41},
+                    sperr::dims_type{100, 100, 8}}) {
+    const auto plane_size = dims[0] * dims[1];
+    const auto total = plane_size * dims[2];
+    auto cdf = sperr::CDF97<double>();
+    cdf.copy_data(in_buf.data(), total, dims);
+    cdf.dwt3d();
+    const auto& fwd = cdf.view_data();
+
+    auto stream = sperr::CDF97_Stream<double>();
+    for (size_t slab : {1, 7, 40}) {
+      stream.start(dims);
+      auto coeffs = sperr::vecd_type(total, 0.0);
+      auto written = std::vector<int>(total, 0);
+      for (size_t z = 0; z < dims[2]; z += slab) {
+        const auto num_planes = std::min(slab, dims[2] - z);
+        ASSERT_EQ(stream.push(in_buf.data() + z * plane_size, num_planes), sperr::RTNType::Good);
+        for (const auto& s : stream.release_slabs()) {
+          ASSERT_EQ(s.vals.size(), s.len_xy[0] * s.len_xy[1]);
+          for (size_t y = 0; y < s.len_xy[1]; y++) {
+            for (size_t x = 0; x < s.len_xy[0]; x++) {
+              if (x >= s.hole_xy[0] || y >= s.hole_xy[1]) {
+                written[s.z * plane_size + y * dims[0] + x]++;
+                coeffs[s.z * plane_size + y * dims[0] + x] = s.vals[y * s.len_xy[0] + x];
+              }
+            }
+          }
+        }
+      }
+      EXPECT_TRUE(stream.finished());
+      EXPECT_TRUE(std::all_of(written.begin(), written.end(), [](auto w) { return w == 1; }));
+      EXPECT_EQ(coeffs, fwd) << dims[0] << " x " << dims[1] << " x " << dims[2];
+      EXPECT_EQ(stream.push(in_buf.data(), 1), sperr::RTNType::WrongLength);
+    }
+  }
+}
+
 }  // namespace
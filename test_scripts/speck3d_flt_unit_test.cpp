@@ -1,10 +1,14 @@
+#include "Quantize_Kernels.h"
 #include "SPECK3D_FLT.h"
 
 #include "gtest/gtest.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
+#include <numeric>
 
 namespace {
 
@@ -235,4 +239,285 @@ TEST(SPECK3D_FLT, OutlierCorrection)
     EXPECT_NEAR(inputd[i], outputd[i], tol);
 }
 
+
+//
+// Test coding in independent code blocks
+//
+TEST(SPECK3D_FLT, CodeBlocks)
+{
+  auto inputf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto total_vals = inputf.size();
+  auto inputd = sperr::vecd_type(total_vals);
+  std::copy(inputf.cbegin(), inputf.cend(), inputd.begin());
+  double tol = 1.0e-5;
+
+  // Encode in PWE mode, with blocks coded by multiple threads.
+  auto encoder = sperr::SPECK3D_FLT();
+  encoder.set_dims(dims);
+  encoder.set_tolerance(tol);
+  encoder.set_code_blocks(true);
+  encoder.set_xform_threads(4);
+  encoder.copy_data(inputd.data(), total_vals);
+  auto rtn = encoder.compress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  auto bitstream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(bitstream);
+
+  // Decode without being told about code blocks.
+  auto decoder = sperr::SPECK3D_FLT();
+  decoder.set_dims(dims);
+  rtn = decoder.use_bitstream(bitstream.data(), bitstream.size());
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  rtn = decoder.decompress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  auto outputd = decoder.release_decoded_data();
+  for (size_t i = 0; i < inputd.size(); i++)
+    EXPECT_NEAR(inputd[i], outputd[i], tol);
+
+  // PSNR mode, and compare against a single stream.
+  const double psnr = 80.0;
+  encoder.set_psnr(psnr);
+  encoder.copy_data(inputd.data(), total_vals);
+  rtn = encoder.compress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  bitstream.clear();
+  encoder.append_encoded_bitstream(bitstream);
+  rtn = decoder.use_bitstream(bitstream.data(), bitstream.size());
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  rtn = decoder.decompress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  outputd = decoder.release_decoded_data();
+  auto single = sperr::SPECK3D_FLT();
+  single.set_dims(dims);
+  single.set_psnr(psnr);
+  single.copy_data(inputd.data(), total_vals);
+  single.compress();
+  auto single_stream = sperr::vec8_type();
+  single.append_encoded_bitstream(single_stream);
+  rtn = decoder.use_bitstream(single_stream.data(), single_stream.size());
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  rtn = decoder.decompress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  EXPECT_EQ(decoder.view_decoded_data(), outputd);  // Same quantized coefficients.
+#ifdef PRINT
+  std::printf("code blocks: %lu bytes, single stream: %lu bytes\n", bitstream.size(),
+              single_stream.size());
+  auto stats = sperr::calc_stats(inputd.data(), outputd.data(), total_vals);
+  std::printf("bpp = %.2f, PSNR = %.2f\n", 8.0 * bitstream.size() / total_vals, stats[2]);
+#endif
+
+  // A truncated bitstream still decodes, with the later blocks partially or entirely missing.
+  rtn = decoder.use_bitstream(bitstream.data(), bitstream.size() / 2);
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  rtn = decoder.decompress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  const auto full = sperr::calc_stats(inputd.data(), outputd.data(), total_vals);
+  const auto part = sperr::calc_stats(inputd.data(), decoder.view_decoded_data().data(), total_vals);
+  EXPECT_LT(part[2], full[2]);
+  EXPECT_GT(part[2], 20.0);
+
+  // Truncate inside a middle block; the blocks after it are entirely missing.
+  const auto table_pos = sizeof(sperr::condi_type);
+  const size_t num_blocks = bitstream[table_pos];
+  ASSERT_GT(num_blocks, 2);
+  auto block_lens = std::vector<uint64_t>(num_blocks);
+  std::memcpy(block_lens.data(), bitstream.data() + table_pos + 1, num_blocks * sizeof(uint64_t));
+  auto cut = table_pos + 1 + num_blocks * sizeof(uint64_t);
+  for (size_t b = 0; b < num_blocks / 2; b++)
+    cut += block_lens[b];
+  cut += block_lens[num_blocks / 2] / 2;
+  rtn = decoder.use_bitstream(bitstream.data(), cut);
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  rtn = decoder.decompress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  const auto mid = sperr::calc_stats(inputd.data(), decoder.view_decoded_data().data(), total_vals);
+  EXPECT_LT(mid[2], full[2]);
+  EXPECT_GT(mid[2], 20.0);
+
+  // Truncate inside the length table, and before the block count. No block data is left, so
+  //    every block decodes as zeros and the output is the constant mean.
+  for (auto len : {table_pos + 1 + 2 * sizeof(uint64_t) + 3, table_pos}) {
+    rtn = decoder.use_bitstream(bitstream.data(), len);
+    ASSERT_EQ(rtn, sperr::RTNType::Good);
+    rtn = decoder.decompress();
+    ASSERT_EQ(rtn, sperr::RTNType::Good);
+    const auto& out = decoder.view_decoded_data();
+    ASSERT_EQ(out.size(), total_vals);
+    EXPECT_TRUE(std::all_of(out.cbegin(), out.cend(), [v = out[0]](auto x) { return x == v; }));
+  }
+}
+
+//
+// Test that fixed-rate mode picks its quantization precision without re-encoding
+//
+TEST(SPECK3D_FLT, FixedRatePrecision)
+{
+  auto inputf = sperr::read_whole_file<float>("../test_data/wmag17.float");
+  const auto dims = sperr::dims_type{17, 17, 17};
+  const auto total_vals = inputf.size();
+  auto inputd = sperr::vecd_type(inputf.cbegin(), inputf.cend());
+
+  // A low bitrate keeps the default precision.
+  auto encoder = sperr::SPECK3D_FLT();
+  encoder.set_dims(dims);
+  encoder.set_bitrate(4.0);
+  encoder.copy_data(inputd.data(), total_vals);
+  auto rtn = encoder.compress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  EXPECT_EQ(encoder.integer_len(), 4);
+  EXPECT_EQ(encoder.view_timing().rate_predicted, 0);
+  EXPECT_EQ(encoder.view_timing().rate_retried, 0);
+
+  // A bitrate beyond a lossless encoding at the default precision is predicted to need more.
+  encoder.set_bitrate(30.0);
+  encoder.copy_data(inputd.data(), total_vals);
+  rtn = encoder.compress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  EXPECT_EQ(encoder.integer_len(), 8);
+  EXPECT_EQ(encoder.view_timing().rate_predicted, 1);
+  EXPECT_EQ(encoder.view_timing().rate_retried, 0);
+
+  auto bitstream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(bitstream);
+  auto decoder = sperr::SPECK3D_FLT();
+  decoder.set_dims(dims);
+  rtn = decoder.use_bitstream(bitstream.data(), bitstream.size());
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  rtn = decoder.decompress();
+  ASSERT_EQ(rtn, sperr::RTNType::Good);
+  EXPECT_EQ(decoder.integer_len(), 8);
+  const auto stats = sperr::calc_stats(inputd.data(), decoder.view_decoded_data().data(),
+                                       total_vals);
+  EXPECT_GT(stats[2], 120.0);
+}
+
+//
+// Test that quantization kernels written for different instruction sets agree with the scalar
+//    ones, on every integer length.
+//
+// The quantization step chosen in PSNR mode, found the way it used to be: starting from
+//    2 * sqrt(3 * t_mse), and decreasing it by 2^(1/4) until the exact MSE meets the target.
+auto exact_q_psnr(sperr::vecd_type vals, sperr::dims_type dims, double psnr) -> double
+{
+  auto condi = sperr::Conditioner();
+  condi.condition(vals, dims);
+  auto [min, max] = std::minmax_element(vals.cbegin(), vals.cend());
+  const auto range = *max - *min;
+  auto cdf = sperr::CDF97<double>();
+  cdf.take_data(std::move(vals), dims);
+  cdf.dwt3d();
+  const auto& coeffs = cdf.view_data();
+
+  const auto t_mse = (range * range) * std::pow(10.0, -psnr / 10.0);
+  auto q = 2.0 * std::sqrt(t_mse * 3.0);
+  auto mse = [&coeffs](double q) {
+    auto sum = 0.0;
+    for (auto v : coeffs) {
+      const auto diff = v - q * std::nearbyint(v * (1.0 / q));
+      sum += diff * diff;
+    }
+    return sum / double(coeffs.size());
+  };
+  while (mse(q) > t_mse)
+    q /= std::exp2(0.25);
+  return q;
+}
+
+TEST(SPECK3D_FLT, PSNRQuantStep)
+{
+  // The quantization step estimated from a histogram of coefficients should be the same as
+  //    evaluating every candidate exactly.
+  auto q_of = [](const sperr::vecd_type& vals, sperr::dims_type dims, double psnr) {
+    auto encoder = sperr::SPECK3D_FLT();
+    encoder.set_dims(dims);
+    encoder.set_psnr(psnr);
+    encoder.copy_data(vals.data(), vals.size());
+    EXPECT_EQ(encoder.compress(), sperr::RTNType::Good);
+    auto bitstream = sperr::vec8_type();
+    encoder.append_encoded_bitstream(bitstream);
+    auto header = sperr::condi_type();
+    std::copy(bitstream.begin(), bitstream.begin() + header.size(), header.begin());
+    return sperr::Conditioner().retrieve_q(header);
+  };
+
+  auto inputf = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  ASSERT_EQ(inputf.size(), dims[0] * dims[1] * dims[2]);
+  const auto inputd = sperr::vecd_type(inputf.cbegin(), inputf.cend());
+  for (auto psnr : {20.0, 45.0, 70.0, 95.0, 120.0, 150.0})
+    EXPECT_EQ(q_of(inputd, dims, psnr), exact_q_psnr(inputd, dims, psnr)) << "PSNR = " << psnr;
+
+  // Too small to be transformed, so the coefficients are the (conditioned) values, which are
+  //    clustered around a few magnitudes instead of spreading evenly within histogram bins.
+  const auto small = sperr::dims_type{8, 8, 8};
+  auto clustered = sperr::vecd_type(small[0] * small[1] * small[2]);
+  for (size_t i = 0; i < clustered.size(); i++) {
+    const auto mag = (i % 16 < 12 ? 1000.0 : 37.0) + double(i % 5) * 0.01;
+    clustered[i] = (i % 2 == 0) ? mag : -mag;
+  }
+  for (double psnr = 20.0; psnr < 80.0; psnr += 1.5)
+    EXPECT_EQ(q_of(clustered, small, psnr), exact_q_psnr(clustered, small, psnr))
+        << "PSNR = " << psnr;
+}
+
+template <typename T>
+void compare_quantize_isa(const sperr::vecd_type& vals, double q)
+{
+  const auto len = vals.size();
+  auto run = [&](sperr::ISAType isa, std::vector<T>& ints, sperr::Bitmask& signs) {
+    ints.assign(len, 0);
+    signs.resize(len);
+    signs.reset();
+    const auto& kernels = sperr::quantize_kernels<T>(isa);
+    kernels.quantize(vals.data(), len, 1.0 / q, ints.data(), signs);
+    auto out = sperr::vecd_type(len);
+    kernels.inv_quantize(ints.data(), signs, len, q, out.data());
+    return out;
+  };
+
+  auto ints_ref = std::vector<T>(), ints = std::vector<T>();
+  auto signs_ref = sperr::Bitmask(), signs = sperr::Bitmask();
+  const auto out_ref = run(sperr::ISAType::Scalar, ints_ref, signs_ref);
+  const auto max_ref = sperr::max_magnitude(vals.data(), len, sperr::ISAType::Scalar);
+  for (auto isa : {sperr::ISAType::AVX2, sperr::ISAType::AVX512}) {
+    if (!sperr::isa_supported(isa))
+      continue;
+    const auto out = run(isa, ints, signs);
+    EXPECT_EQ(ints, ints_ref) << "ISA = " << int(isa);
+    EXPECT_EQ(signs, signs_ref) << "ISA = " << int(isa);
+    EXPECT_EQ(std::memcmp(out.data(), out_ref.data(), len * sizeof(double)), 0)
+        << "ISA = " << int(isa);
+    EXPECT_EQ(sperr::max_magnitude(vals.data(), len, isa), max_ref) << "ISA = " << int(isa);
+  }
+}
+
+TEST(SPECK3D_FLT, QuantizeISA)
+{
+  auto inputf = sperr::read_whole_file<float>("../test_data/wmag17.float");
+  ASSERT_EQ(inputf.size(), 17 * 17 * 17);
+  auto vals = sperr::vecd_type(inputf.cbegin(), inputf.cend());
+
+  // Center the values so that half of them are negative, then plant ties and signed zeros.
+  const auto mean = std::accumulate(vals.cbegin(), vals.cend(), 0.0) / double(vals.size());
+  for (auto& v : vals)
+    v -= mean;
+  const auto planted = {0.5, -0.5, 1.5, -1.5, 2.5, -2.5, -0.0, 0.0, -0.4, 0.4};
+  for (size_t i = 0; i < vals.size(); i += 37)
+    vals[i] = *(planted.begin() + (i / 37) % planted.size());
+
+  // Choose `q` so that the biggest magnitude just fits in each integer length.
+  const auto maxd = sperr::max_magnitude(vals.data(), vals.size(), sperr::ISAType::Scalar);
+  compare_quantize_isa<uint8_t>(vals, maxd / 255.0);
+  compare_quantize_isa<uint16_t>(vals, maxd / 65535.0);
+  compare_quantize_isa<uint32_t>(vals, maxd / 4294967295.0);
+  compare_quantize_isa<uint64_t>(vals, maxd / 1e12);
+
+  // With a step of 1.0, the planted values are exact ties, and all magnitudes fit in uint8_t.
+  ASSERT_LT(maxd, 255.0);
+  compare_quantize_isa<uint8_t>(vals, 1.0);
+  compare_quantize_isa<uint16_t>(vals, 1.0);
+  compare_quantize_isa<uint32_t>(vals, 1.0);
+}
+
 }  // namespace
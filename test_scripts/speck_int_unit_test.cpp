@@ -267,6 +267,43 @@ TEST(SPECK1D_INT, RandomRandom)
     EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i));
 }
 
+TEST(SPECK1D_INT, Sparse)
+{
+  // A long array that's mostly zeros, with values placed around block boundaries of the
+  //    encoder's search hierarchy.
+  const auto dims = sperr::dims_type{64 * 64 * 64 + 17, 1, 1};
+  auto input = std::vector<uint32_t>(dims[0], 0);
+  auto input_signs = sperr::Bitmask(dims[0]);
+  input_signs.reset_true();
+  for (size_t i : {0ul, 63ul, 64ul, 4095ul, 4097ul, 131071ul, 131072ul, 262143ul, 262160ul})
+    input[i] = i % 1000 + 1;
+  input_signs.wbit(64, false);
+  input_signs.wbit(262160, false);
+
+  // Encode
+  auto encoder = sperr::SPECK1D_INT_ENC<uint32_t>();
+  encoder.use_coeffs(input, input_signs);
+  encoder.set_dims(dims);
+  encoder.encode();
+  auto bitstream = sperr::vec8_type();
+  encoder.append_encoded_bitstream(bitstream);
+
+  // Decode
+  auto decoder = sperr::SPECK1D_INT_DEC<uint32_t>();
+  decoder.set_dims(dims);
+  decoder.use_bitstream(bitstream.data(), bitstream.size());
+  decoder.decode();
+  auto output = decoder.release_coeffs();
+  auto output_signs = decoder.release_signs();
+
+  EXPECT_EQ(input, output);
+  for (size_t i = 0; i < input.size(); i++) {
+    if (input[i] != 0) {
+      EXPECT_EQ(input_signs.rbit(i), output_signs.rbit(i)) << "at idx = " << i;
+    }
+  }
+}
+
 //
 // Starting 2D test cases
 //
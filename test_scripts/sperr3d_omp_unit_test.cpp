@@ -344,4 +344,181 @@ TEST(sperr3d_multi_res, canonical)
   }
 }
 
+TEST(sperr3d_timing, chunks_and_threads)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 41};
+  const auto num_chunks = sperr::chunk_volume(dims, chunks).size();
+  const auto speck = size_t(sperr::StageType::Speck);
+  const auto outlier = size_t(sperr::StageType::Outlier);
+
+  // Timing is off by default.
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_tolerance(6.7e-6);
+  encoder.set_num_threads(3);
+  encoder.compress(input.data(), input.size());
+  EXPECT_TRUE(encoder.view_chunk_timing().empty());
+  EXPECT_TRUE(encoder.view_thread_timing().empty());
+  const auto stream = encoder.get_encoded_bitstream();
+
+  // Enabling timing doesn't change the bitstream. Bytes produced by the SPECK and outlier
+  //    coders make up every chunk bitstream, except for its conditioner header.
+  encoder.enable_timing(true);
+  encoder.compress(input.data(), input.size());
+  EXPECT_EQ(encoder.get_encoded_bitstream(), stream);
+  const auto& chunk_times = encoder.view_chunk_timing();
+  ASSERT_EQ(chunk_times.size(), num_chunks);
+  auto sum = sperr::StageTimes();
+  for (const auto& t : chunk_times) {
+    EXPECT_GT(t.bytes[speck], 0);
+    EXPECT_GT(t.total_seconds(), 0.0);
+    sum += t;
+  }
+  auto sum_threads = sperr::StageTimes();
+  for (const auto& t : encoder.view_thread_timing())
+    sum_threads += t;
+  EXPECT_EQ(sum_threads.bytes, sum.bytes);
+  EXPECT_LT(sum.bytes[speck] + sum.bytes[outlier], stream.size());
+
+  // Decompression records every chunk as well.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(2);
+  decoder.enable_timing(true);
+  decoder.use_bitstream(stream.data(), stream.size());
+  decoder.decompress(stream.data());
+  ASSERT_EQ(decoder.view_chunk_timing().size(), num_chunks);
+  for (const auto& t : decoder.view_chunk_timing())
+    EXPECT_EQ(t.bytes[size_t(sperr::StageType::Xform)], 64 * 64 * 41 * sizeof(double));
+}
+
+//
+// Test decompressing into caller-supplied buffers.
+//
+TEST(sperr3d_decompress, caller_buffer)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 64};
+  const auto total_len = dims[0] * dims[1] * dims[2];
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_psnr(88.0);
+  encoder.set_num_threads(3);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  // Decompress into the internal buffer first, as the reference.
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(3);
+  decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(decoder.decompress(stream.data(), true), RTNType::Good);
+  const auto ref = decoder.release_decoded_data();
+  const auto ref_hierarchy = decoder.release_hierarchy();
+  ASSERT_EQ(ref.size(), total_len);
+
+  // Decompress into a double buffer.
+  auto outputd = sperr::vecd_type(total_len);
+  ASSERT_EQ(decoder.decompress(stream.data(), outputd.data()), RTNType::Good);
+  EXPECT_EQ(outputd, ref);
+  EXPECT_TRUE(decoder.view_decoded_data().empty());
+
+  // Decompress into a float buffer, together with the hierarchy.
+  auto outputf = sperr::vecf_type(total_len);
+  ASSERT_EQ(decoder.decompress(stream.data(), outputf.data(), true), RTNType::Good);
+  for (size_t i = 0; i < total_len; i++)
+    ASSERT_EQ(outputf[i], static_cast<float>(ref[i])) << "at idx = " << i;
+  EXPECT_EQ(decoder.view_hierarchy(), ref_hierarchy);
+
+  // A null buffer is rejected.
+  EXPECT_EQ(decoder.decompress(stream.data(), static_cast<float*>(nullptr)), RTNType::Error);
+}
+
+TEST(sperr3d_decompress, strided_buffer)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 64};
+  const auto total_len = dims[0] * dims[1] * dims[2];
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_psnr(88.0);
+  encoder.compress(input.data(), input.size());
+  auto stream = encoder.get_encoded_bitstream();
+
+  auto decoder = sperr::SPERR3D_OMP_D();
+  decoder.set_num_threads(3);
+  decoder.use_bitstream(stream.data(), stream.size());
+  ASSERT_EQ(decoder.decompress(stream.data()), RTNType::Good);
+  const auto ref = decoder.release_decoded_data();
+  ASSERT_EQ(ref.size(), total_len);
+
+  // Decompress into the interior of a bigger array, which has 2 ghost cells on every side,
+  //    and whose values are pairs of fields (the volume goes to the second field).
+  const auto big = sperr::dims_type{dims[0] + 4, dims[1] + 4, dims[2] + 4};
+  const auto strides = std::array<size_t, 3>{2, 2 * big[0], 2 * big[0] * big[1]};
+  auto outputf = sperr::vecf_type(2 * big[0] * big[1] * big[2], -1.0f);
+  auto* dst = outputf.data() + 1 + 2 * strides[0] + 2 * strides[1] + 2 * strides[2];
+  ASSERT_EQ(decoder.decompress(stream.data(), dst, strides), RTNType::Good);
+
+  size_t count = 0;
+  for (size_t z = 0; z < big[2]; z++)
+    for (size_t y = 0; y < big[1]; y++)
+      for (size_t x = 0; x < big[0]; x++)
+        for (size_t f = 0; f < 2; f++) {
+          const auto val = outputf[f + x * strides[0] + y * strides[1] + z * strides[2]];
+          const bool inside = f == 1 && x >= 2 && x < dims[0] + 2 && y >= 2 &&
+                              y < dims[1] + 2 && z >= 2 && z < dims[2] + 2;
+          if (inside) {
+            const auto idx = (x - 2) + (y - 2) * dims[0] + (z - 2) * dims[0] * dims[1];
+            ASSERT_EQ(val, static_cast<float>(ref[idx])) << "at idx = " << idx;
+            count++;
+          }
+          else
+            ASSERT_EQ(val, -1.0f);
+        }
+  EXPECT_EQ(count, total_len);
+
+  // Zero strides are rejected.
+  EXPECT_EQ(decoder.decompress(stream.data(), dst, {0, 2, 4}), RTNType::Error);
+}
+
+//
+// Test compressing from strided views.
+//
+TEST(sperr3d_compress, strided_buffer)
+{
+  auto input = sperr::read_whole_file<float>("../test_data/vorticity.128_128_41");
+  const auto dims = sperr::dims_type{128, 128, 41};
+  const auto chunks = sperr::dims_type{64, 64, 64};
+
+  auto encoder = sperr::SPERR3D_OMP_C();
+  encoder.set_dims_and_chunks(dims, chunks);
+  encoder.set_psnr(88.0);
+  encoder.set_num_threads(3);
+  ASSERT_EQ(encoder.compress(input.data(), input.size()), RTNType::Good);
+  const auto ref = encoder.get_encoded_bitstream();
+
+  // Put the volume in the interior of a bigger array, which has 2 ghost cells on every side,
+  //    and whose values are pairs of fields (the volume is the second field).
+  const auto big = sperr::dims_type{dims[0] + 4, dims[1] + 4, dims[2] + 4};
+  const auto strides = std::array<size_t, 3>{2, 2 * big[0], 2 * big[0] * big[1]};
+  auto padded = sperr::vecf_type(2 * big[0] * big[1] * big[2], 1e9f);
+  const auto offset = 1 + 2 * strides[0] + 2 * strides[1] + 2 * strides[2];
+  for (size_t z = 0; z < dims[2]; z++)
+    for (size_t y = 0; y < dims[1]; y++)
+      for (size_t x = 0; x < dims[0]; x++)
+        padded[offset + x * strides[0] + y * strides[1] + z * strides[2]] =
+            input[x + y * dims[0] + z * dims[0] * dims[1]];
+
+  ASSERT_EQ(encoder.compress(padded.data(), strides, offset), RTNType::Good);
+  EXPECT_EQ(encoder.get_encoded_bitstream(), ref);
+
+  // Zero strides are rejected.
+  EXPECT_EQ(encoder.compress(padded.data(), {2, 0, 4}, offset), RTNType::Error);
+}
+
 }  // anonymous namespace
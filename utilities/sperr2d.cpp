@@ -89,6 +89,21 @@ auto output_buffer(const sperr::vecd_type& buf,
   return 0;
 }
 
+// This function prints the wall time spent in, and bytes produced by, every stage.
+void output_timing(const char* task, const sperr::StageTimes& times)
+{
+  const auto total = times.total_seconds();
+  std::printf("%s timing: %.4f seconds\n", task, total);
+  for (size_t i = 0; i < times.seconds.size(); i++) {
+    const auto stage = static_cast<sperr::StageType>(i);
+    std::printf("  %-10s %10.4fs %6.1f%% %12zu bytes\n", sperr::stage_name(stage),
+                times.seconds[i], total > 0.0 ? times.seconds[i] / total * 100.0 : 0.0,
+                times.bytes[i]);
+  }
+  if (times.rate_predicted + times.rate_retried > 0)
+    std::printf("  Precision raised: %s\n", times.rate_predicted ? "predicted" : "retried");
+}
+
 int main(int argc, char* argv[])
 {
   // Parse command line options
@@ -156,6 +171,10 @@ int main(int argc, char* argv[])
       ->needs(cptr)
       ->group("Output settings");
 
+  auto timing = bool{false};
+  app.add_flag("--timing", timing, "Show the time spent in every stage of (de)compression.")
+      ->group("Output settings");
+
   //
   // Compression settings
   //
@@ -244,6 +263,7 @@ int main(int argc, char* argv[])
     }
     auto encoder = std::make_unique<sperr::SPECK2D_FLT>();
     encoder->set_dims(dims);
+    encoder->enable_timing(timing);
     if (ftype == 32)
       encoder->copy_data(reinterpret_cast<const float*>(input.data()), total_vals);
     else
@@ -273,6 +293,8 @@ int main(int argc, char* argv[])
       std::cout << "Compression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (timing)
+      output_timing("Compression", encoder->view_timing());
 
     // Assemble the output bitstream.
     auto stream = sperr::vec8_type(header_len);
@@ -306,6 +328,7 @@ int main(int argc, char* argv[])
     if (print_stats || !decomp_f64.empty() || !decomp_f32.empty() || multi_res) {
       auto decoder = std::make_unique<sperr::SPECK2D_FLT>();
       decoder->set_dims(dims);
+      decoder->enable_timing(timing);
       // !! Remember the header thing !!
       decoder->use_bitstream(stream.data() + header_len, stream.size() - header_len);
       rtn = decoder->decompress(multi_res);
@@ -313,6 +336,8 @@ int main(int argc, char* argv[])
         std::cout << "Decompression failed!" << std::endl;
         return __LINE__ % 256;
       }
+      if (timing)
+        output_timing("Decompression", decoder->view_timing());
 
       // Save the decompressed data, and then deconstruct the decoder to free up some memory!
       auto hierarchy = decoder->release_hierarchy();
@@ -387,6 +412,7 @@ int main(int argc, char* argv[])
     const auto dims = sperr::dims_type{dim2d[0], dim2d[1], 1ul};
     auto decoder = std::make_unique<sperr::SPECK2D_FLT>();
     decoder->set_dims(dims);
+    decoder->enable_timing(timing);
     decoder->use_bitstream(input.data() + header_len, input.size() - header_len);
     const auto multi_res = (!decomp_lowres_f32.empty()) || (!decomp_lowres_f64.empty());
     auto rtn = decoder->decompress(multi_res);
@@ -394,6 +420,8 @@ int main(int argc, char* argv[])
       std::cout << "Decompression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (timing)
+      output_timing("Decompression", decoder->view_timing());
 
     // Save the decompressed data, and then deconstruct the decoder to free up some memory!
     auto hierarchy = decoder->release_hierarchy();
@@ -5,6 +5,7 @@
 #include "CLI/Config.hpp"
 #include "CLI/Formatter.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 #include <cstring>
@@ -94,6 +95,51 @@ auto output_buffer(const sperr::vecd_type& buf,
   return 0;
 }
 
+// This function is used to output the decompressed volume that's decoded in single precision.
+auto output_buffer(const sperr::vecf_type& buf, const std::string& name_f32) -> int
+{
+  if (!name_f32.empty()) {
+    auto rtn = sperr::write_n_bytes(name_f32, buf.size() * sizeof(float), buf.data());
+    if (rtn != sperr::RTNType::Good) {
+      std::cout << "Writing decompressed data failed: " << name_f32 << std::endl;
+      return __LINE__;
+    }
+  }
+
+  return 0;
+}
+
+// This function prints the wall time spent in, and bytes produced by, every stage, summed up
+// over all chunks, and then how the time is distributed among chunks and threads.
+void output_timing(const char* task,
+                   const std::vector<sperr::StageTimes>& chunk_times,
+                   const std::vector<sperr::StageTimes>& thread_times)
+{
+  auto sum = sperr::StageTimes();
+  for (const auto& t : chunk_times)
+    sum += t;
+  const auto total = sum.total_seconds();
+  std::printf("%s timing: %.4f seconds in %zu chunk(s)\n", task, total, chunk_times.size());
+  for (size_t i = 0; i < sum.seconds.size(); i++) {
+    const auto stage = static_cast<sperr::StageType>(i);
+    std::printf("  %-10s %10.4fs %6.1f%% %12zu bytes\n", sperr::stage_name(stage),
+                sum.seconds[i], total > 0.0 ? sum.seconds[i] / total * 100.0 : 0.0, sum.bytes[i]);
+  }
+  if (sum.rate_predicted + sum.rate_retried > 0)
+    std::printf("  Precision raised: %zu chunk(s) predicted, %zu chunk(s) retried\n",
+                sum.rate_predicted, sum.rate_retried);
+
+  if (!chunk_times.empty()) {
+    auto [min, max] = std::minmax_element(
+        chunk_times.cbegin(), chunk_times.cend(),
+        [](const auto& a, const auto& b) { return a.total_seconds() < b.total_seconds(); });
+    std::printf("  Per chunk:  min = %.4fs, max = %.4fs, mean = %.4fs\n", min->total_seconds(),
+                max->total_seconds(), total / double(chunk_times.size()));
+  }
+  for (size_t i = 0; i < thread_times.size(); i++)
+    std::printf("  Thread %-3zu %10.4fs\n", i, thread_times[i].total_seconds());
+}
+
 int main(int argc, char* argv[])
 {
   // Parse command line options
@@ -168,6 +214,11 @@ int main(int argc, char* argv[])
       ->needs(cptr)
       ->group("Output settings");
 
+  auto timing = bool{false};
+  app.add_flag("--timing", timing,
+               "Print the time spent in every stage of (de)compression, per chunk and thread.")
+      ->group("Output settings");
+
   //
   // Compression settings
   //
@@ -277,6 +328,7 @@ int main(int argc, char* argv[])
     auto encoder = std::make_unique<sperr::SPERR3D_OMP_C>();
     encoder->set_dims_and_chunks(dims, chunks);
     encoder->set_num_threads(omp_num_threads);
+    encoder->enable_timing(timing);
     if (pwe != 0.0)
       encoder->set_tolerance(pwe);
     else if (psnr != 0.0)
@@ -299,6 +351,8 @@ int main(int argc, char* argv[])
       std::cout << "Compression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (timing)
+      output_timing("Compression", encoder->view_chunk_timing(), encoder->view_thread_timing());
 
     // If not calculating stats, we can free up some memory now!
     if (!print_stats) {
@@ -325,12 +379,26 @@ int main(int argc, char* argv[])
     if (print_stats || !decomp_f64.empty() || !decomp_f32.empty() || multi_res) {
       auto decoder = std::make_unique<sperr::SPERR3D_OMP_D>();
       decoder->set_num_threads(omp_num_threads);
+      decoder->enable_timing(timing);
       decoder->use_bitstream(stream.data(), stream.size());
-      rtn = decoder->decompress(stream.data(), multi_res);
+
+      // Decode straight into single precision, unless double precision is needed for the
+      //    output or for the statistics, so that no volume in double precision is allocated.
+      auto outputf = sperr::vecf_type();
+      const auto decode_f32 = decomp_f64.empty() && (ftype == 32 || !print_stats);
+      if (decode_f32) {
+        outputf.resize(total_vals);
+        rtn = decoder->decompress(stream.data(), outputf.data(), multi_res);
+      }
+      else
+        rtn = decoder->decompress(stream.data(), multi_res);
       if (rtn != sperr::RTNType::Good) {
         std::cout << "Decompression failed!" << std::endl;
         return __LINE__ % 256;
       }
+      if (timing)
+        output_timing("Decompression", decoder->view_chunk_timing(),
+                      decoder->view_thread_timing());
 
       // Save the decompressed data, and then deconstruct the decoder to free up some memory!
       auto outputd = decoder->release_decoded_data();
@@ -345,7 +413,10 @@ int main(int argc, char* argv[])
       hierarchy.shrink_to_fit();
 
       // Output the decompressed volume (maybe).
-      ret = output_buffer(outputd, decomp_f64, decomp_f32);
+      if (decode_f32)
+        ret = output_buffer(outputf, decomp_f32);
+      else
+        ret = output_buffer(outputd, decomp_f64, decomp_f32);
       if (ret)
         return __LINE__ % 256;
 
@@ -355,8 +426,10 @@ int main(int argc, char* argv[])
         double rmse, linfy, print_psnr, min, max, sigma;
         if (ftype == 32) {
           const float* inputf = reinterpret_cast<const float*>(input.data());
-          auto outputf = sperr::vecf_type(total_vals);
-          std::copy(outputd.cbegin(), outputd.cend(), outputf.begin());
+          if (!decode_f32) {
+            outputf.resize(total_vals);
+            std::copy(outputd.cbegin(), outputd.cend(), outputf.begin());
+          }
           auto stats = sperr::calc_stats(inputf, outputf.data(), total_vals, omp_num_threads);
           rmse = stats[0];
           linfy = stats[1];
@@ -390,13 +463,27 @@ int main(int argc, char* argv[])
     assert(dflag);
     auto decoder = std::make_unique<sperr::SPERR3D_OMP_D>();
     decoder->set_num_threads(omp_num_threads);
+    decoder->enable_timing(timing);
     decoder->use_bitstream(input.data(), input.size());
     const auto multi_res = (!decomp_lowres_f32.empty()) || (!decomp_lowres_f64.empty());
-    auto rtn = decoder->decompress(input.data(), multi_res);
+
+    // Decode straight into single precision, unless double precision is asked for.
+    auto outputf = sperr::vecf_type();
+    const auto decode_f32 = decomp_f64.empty();
+    auto rtn = sperr::RTNType::Good;
+    if (decode_f32) {
+      const auto vdims = decoder->get_dims();
+      outputf.resize(vdims[0] * vdims[1] * vdims[2]);
+      rtn = decoder->decompress(input.data(), outputf.data(), multi_res);
+    }
+    else
+      rtn = decoder->decompress(input.data(), multi_res);
     if (rtn != sperr::RTNType::Good) {
       std::cout << "Decompression failed!" << std::endl;
       return __LINE__ % 256;
     }
+    if (timing)
+      output_timing("Decompression", decoder->view_chunk_timing(), decoder->view_thread_timing());
 
     auto hierarchy = decoder->release_hierarchy();
     auto outputd = decoder->release_decoded_data();
@@ -412,7 +499,10 @@ int main(int argc, char* argv[])
     hierarchy.shrink_to_fit();
 
     // Output the decompressed volume (maybe).
-    ret = output_buffer(outputd, decomp_f64, decomp_f32);
+    if (decode_f32)
+      ret = output_buffer(outputf, decomp_f32);
+    else
+      ret = output_buffer(outputd, decomp_f64, decomp_f32);
     if (ret)
       return __LINE__ % 256;
   }